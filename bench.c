@@ -0,0 +1,676 @@
+#define _GNU_SOURCE
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__linux__)
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+#include "raylib.h"
+#include "raymath.h"
+
+#define WORLD_IMPLEMENTATION
+#include "world.h"
+
+#define DDA_IMPLEMENTATION
+#include "dda.h"
+
+#define JOBS_IMPLEMENTATION
+#include "jobs.h"
+
+#define HEIGHTMAP_IMPLEMENTATION
+#include "heightmap.h"
+
+#define STREAM_IMPLEMENTATION
+#include "stream.h"
+
+// Headless benchmark for the traversal kernels, no window is opened
+//
+//   bench [--quick] [--json results.json]
+//   bench --export-world size file
+//
+// Every kernel traces the same ray sets (random, coherent camera rays, axis aligned worst
+// cases and rays coming in from outside the world) over generated worlds of several sizes
+// and densities. Results go to stdout as a table and, with --json, to a file for regression
+// tracking. Cache misses come from the hardware counters (Linux perf events) and read as
+// unavailable elsewhere.
+//
+// Each world is also meshed: every solid voxel looks at its six neighbours and counts the
+// faces a culled mesher would emit, chunk by chunk. Build a second binary with
+// -DWORLD_LAYOUT_MORTON (and -mbmi2 where the CPU has it) to compare the voxel layouts,
+// the layout is part of the output.
+//
+// --export-world only writes the terrain world of the given size as a stream.h world file,
+// for dda3 --stream or --load.
+
+#define RAY_COUNT 100000
+#define QUICK_RAY_COUNT 10000
+#define SCALING_RAY_COUNT 1000000
+#define SCALING_TILE_SIZE 1024
+#define MAX_RESULTS 1024
+
+#if defined(WORLD_LAYOUT_MORTON)
+    #define LAYOUT_NAME "morton"
+#else
+    #define LAYOUT_NAME "linear"
+#endif
+
+typedef enum {
+    SCENE_TERRAIN = 1,
+    SCENE_SCATTER = 2,
+} SceneKind;
+
+typedef struct BenchScene {
+    SceneKind kind;
+    const char *name;
+    float density;              // Filled fraction for scatter worlds
+    const World *world;
+    const HeightMap *map;       // Heights of the terrain, NULL for scatter worlds
+} BenchScene;
+
+// Traces one ray, returns the steps it took
+typedef int (*BenchFunc)(const BenchScene *scene, Vector3 from, Vector3 dir, float maxDistance, bool *hit);
+
+typedef struct Kernel {
+    const char *name;
+    BenchFunc trace;
+    int scenes;                 // SceneKind bits the kernel runs on
+} Kernel;
+
+typedef struct BenchResult {
+    const char *scene;
+    float density;
+    int size;
+    const char *rays;
+    const char *kernel;
+    int rayCount;
+    double raysPerSecond;
+    double stepsPerRay;         // Negative when the kernel does not count steps
+    double cacheMissesPerRay;   // Negative when no counter is available
+    double hitRate;
+} BenchResult;
+
+BenchResult results[MAX_RESULTS];
+int resultCount = 0;
+int rayCount = RAY_COUNT;
+
+//----------------------------------------------------------------------------------
+// Kernels
+//----------------------------------------------------------------------------------
+int TraceFlat(const BenchScene *scene, Vector3 from, Vector3 dir, float maxDistance, bool *hit)
+{
+    RayHit h = DDA3DFlat(from, dir, maxDistance, scene->world);
+    *hit = h.hit;
+    return h.steps;
+}
+
+int TraceBrick(const BenchScene *scene, Vector3 from, Vector3 dir, float maxDistance, bool *hit)
+{
+    RayHit h = DDA3DBrick(from, dir, maxDistance, scene->world);
+    *hit = h.hit;
+    return h.steps;
+}
+
+int TraceWalk3D(const BenchScene *scene, Vector3 from, Vector3 dir, float maxDistance, bool *hit)
+{
+    (void)scene;
+    *hit = false;
+    return DDA3DWalk(from, dir, maxDistance, NULL, NULL, 0);
+}
+
+int TraceWalkX(const BenchScene *scene, Vector3 from, Vector3 dir, float maxDistance, bool *hit)
+{
+    *hit = false;
+    return DDAXWalk(from, dir, (float)scene->world->size, (int)maxDistance*2, NULL, NULL);
+}
+
+int TraceWalk2D(const BenchScene *scene, Vector3 from, Vector3 dir, float maxDistance, bool *hit)
+{
+    (void)scene;
+    *hit = false;
+    Vector2 flat = { dir.x, dir.z };
+    float length = Vector2Length(flat);
+    if (length < 1e-6f) return 0;
+    return DDA2DWalk((Vector2){ from.x, from.z }, Vector2Scale(flat, 1.0f/length), maxDistance*length, NULL, 0);
+}
+
+int TraceHeightMip(const BenchScene *scene, Vector3 from, Vector3 dir, float maxDistance, bool *hit)
+{
+    int steps = 0;
+    *hit = TraceHeightMapShadow(scene->map, from, Vector3Add(from, Vector3Scale(dir, maxDistance)), NULL, 0, &steps);
+    return steps;
+}
+
+int TraceHeightFlat(const BenchScene *scene, Vector3 from, Vector3 dir, float maxDistance, bool *hit)
+{
+    int steps = 0;
+    *hit = TraceHeightMapShadowFlat(scene->map, from, Vector3Add(from, Vector3Scale(dir, maxDistance)), &steps);
+    return steps;
+}
+
+Kernel kernels[] = {
+    { "DDA3DFlat", TraceFlat, SCENE_TERRAIN | SCENE_SCATTER },
+    { "DDA3DBrick", TraceBrick, SCENE_TERRAIN | SCENE_SCATTER },
+    { "DDA3DWalk", TraceWalk3D, SCENE_TERRAIN },        // Geometry only, the world does not matter
+    { "DDAXWalk", TraceWalkX, SCENE_TERRAIN },
+    { "DDA2DWalk", TraceWalk2D, SCENE_TERRAIN },
+    { "HeightMip", TraceHeightMip, SCENE_TERRAIN },
+    { "HeightFlat", TraceHeightFlat, SCENE_TERRAIN },
+};
+
+//----------------------------------------------------------------------------------
+// Measurement
+//----------------------------------------------------------------------------------
+double NowSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+#if defined(__linux__)
+int cacheMissCounter = -1;
+
+void InitCacheMissCounter(void)
+{
+    struct perf_event_attr attr = {0};
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    cacheMissCounter = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+void StartCacheMisses(void)
+{
+    if (cacheMissCounter < 0) return;
+    ioctl(cacheMissCounter, PERF_EVENT_IOC_RESET, 0);
+    ioctl(cacheMissCounter, PERF_EVENT_IOC_ENABLE, 0);
+}
+
+// Misses since StartCacheMisses, -1 without a counter
+long long StopCacheMisses(void)
+{
+    if (cacheMissCounter < 0) return -1;
+    ioctl(cacheMissCounter, PERF_EVENT_IOC_DISABLE, 0);
+    long long count = 0;
+    if (read(cacheMissCounter, &count, sizeof(count)) != sizeof(count)) return -1;
+    return count;
+}
+#else
+void InitCacheMissCounter(void) { }
+void StartCacheMisses(void) { }
+long long StopCacheMisses(void) { return -1; }
+#endif
+
+void AddResult(const BenchScene *scene, const char *rays, const char *kernel, double elapsed, long long steps, long long misses, int hits)
+{
+    BenchResult r = {
+        scene->name, scene->density, scene->world->size, rays, kernel, rayCount,
+        rayCount / elapsed,
+        (steps >= 0) ? (double)steps / rayCount : -1.0,
+        (misses >= 0) ? (double)misses / rayCount : -1.0,
+        (double)hits / rayCount
+    };
+    if (resultCount < MAX_RESULTS) results[resultCount++] = r;
+
+    char stepText[16] = "-", missText[16] = "-";
+    if (r.stepsPerRay >= 0) snprintf(stepText, sizeof(stepText), "%.1f", r.stepsPerRay);
+    if (r.cacheMissesPerRay >= 0) snprintf(missText, sizeof(missText), "%.2f", r.cacheMissesPerRay);
+    printf("%-8s %5.3f %5d  %-7s %-11s %10.2f %10s %10s %8.1f%%\n", r.scene, r.density, r.size, r.rays, r.kernel,
+        r.raysPerSecond * 1e-6, stepText, missText, 100.0 * r.hitRate);
+}
+
+//----------------------------------------------------------------------------------
+// Worlds and rays
+//----------------------------------------------------------------------------------
+float RandomFloat(void)
+{
+    return rand() / (float)RAND_MAX;
+}
+
+Vector3 RandomDirection(void)
+{
+    Vector3 d;
+    do {
+        d = (Vector3){ RandomFloat()*2 - 1, RandomFloat()*2 - 1, RandomFloat()*2 - 1 };
+    } while (Vector3LengthSqr(d) > 1 || Vector3LengthSqr(d) < 0.0001f);
+    return Vector3Normalize(d);
+}
+
+// Rolling hills filling the bottom quarter of the world, open air above. The same heights
+// go into the HeightMap for the heightfield kernels
+void GenTerrainWorld(World *world, HeightMap *map)
+{
+    int size = world->size;
+    for (int z = 0; z < size; z++)
+    {
+        for (int x = 0; x < size; x++)
+        {
+            int h = size/4 + (int)(size/8 * sinf(x * 0.05f) * cosf(z * 0.07f));
+            for (int y = 0; y < h; y++)
+            {
+                SetWorld((Vector3i){x, y, z}, 1, world);
+            }
+            SetHeight(map, x, z, h);
+        }
+    }
+}
+
+// Uniformly scattered voxels at the given density
+void GenScatterWorld(World *world, float density)
+{
+    int size = world->size;
+    long count = (long)(density * size * size * size);
+    for (long i = 0; i < count; i++)
+    {
+        SetWorld((Vector3i){ rand() % size, rand() % size, rand() % size }, 1, world);
+    }
+}
+
+// Random origins (in the open air above terrain) and random directions
+void GenRandomRays(const BenchScene *scene, Vector3 *origins, Vector3 *dirs)
+{
+    float size = (float)scene->world->size;
+    float minY = (scene->kind == SCENE_TERRAIN) ? size*0.5f : 0.0f;
+    for (int i = 0; i < rayCount; i++)
+    {
+        origins[i] = (Vector3){ RandomFloat() * size, minY + RandomFloat() * (size - minY), RandomFloat() * size };
+        dirs[i] = RandomDirection();
+    }
+}
+
+// Pinhole camera in a top corner looking at the middle, pixels in row order, so neighbouring
+// rays walk neighbouring cells
+void GenCameraRays(const BenchScene *scene, Vector3 *origins, Vector3 *dirs)
+{
+    float size = (float)scene->world->size;
+    Vector3 eye = { 0.5f, 0.9f*size, 0.5f };
+    Vector3 forward = Vector3Normalize(Vector3Subtract((Vector3){ size*0.5f, size*0.25f, size*0.5f }, eye));
+    Vector3 right = Vector3Normalize(Vector3CrossProduct(forward, (Vector3){ 0, 1, 0 }));
+    Vector3 up = Vector3CrossProduct(right, forward);
+
+    int width = (int)sqrtf((float)rayCount);
+    float half = tanf(30.0f*DEG2RAD);
+    for (int i = 0; i < rayCount; i++)
+    {
+        float u = ((i % width) + 0.5f) / width * 2 - 1;
+        float v = ((i / width) + 0.5f) / width * 2 - 1;
+        origins[i] = eye;
+        dirs[i] = Vector3Normalize(Vector3Add(forward, Vector3Add(Vector3Scale(right, u*half), Vector3Scale(up, -v*half))));
+    }
+}
+
+// Rays parallel to an axis crossing the whole world from one face, the longest walks there are
+void GenAxisRays(const BenchScene *scene, Vector3 *origins, Vector3 *dirs)
+{
+    float size = (float)scene->world->size;
+    for (int i = 0; i < rayCount; i++)
+    {
+        int axis = i % 3;
+        bool negative = (i / 3) % 2;
+        float p[3] = { RandomFloat() * size, RandomFloat() * size, RandomFloat() * size };
+        float d[3] = { 0, 0, 0 };
+        p[axis] = negative ? size - 0.5f : 0.5f;
+        d[axis] = negative ? -1.0f : 1.0f;
+        origins[i] = (Vector3){ p[0], p[1], p[2] };
+        dirs[i] = (Vector3){ d[0], d[1], d[2] };
+    }
+}
+
+// Origins outside the world, 1.5 sizes from its center: half aim at a random voxel, half
+// go anywhere and mostly miss. The kernels should only pay for the part inside the world
+void GenOutsideRays(const BenchScene *scene, Vector3 *origins, Vector3 *dirs)
+{
+    float size = (float)scene->world->size;
+    Vector3 center = { size*0.5f, size*0.5f, size*0.5f };
+    for (int i = 0; i < rayCount; i++)
+    {
+        origins[i] = Vector3Add(center, Vector3Scale(RandomDirection(), size*1.5f));
+        Vector3 target = { RandomFloat() * size, RandomFloat() * size, RandomFloat() * size };
+        dirs[i] = (i % 2) ? RandomDirection() : Vector3Normalize(Vector3Subtract(target, origins[i]));
+    }
+}
+
+void RunKernels(const BenchScene *scene, const char *rays, Vector3 *origins, Vector3 *dirs, RayBatch *batch)
+{
+    float maxDistance = scene->world->size * 2.0f;
+
+    for (int k = 0; k < (int)(sizeof(kernels)/sizeof(kernels[0])); k++)
+    {
+        if (!(kernels[k].scenes & scene->kind)) continue;
+
+        long long steps = 0;
+        int hits = 0;
+
+        StartCacheMisses();
+        double start = NowSeconds();
+        for (int i = 0; i < rayCount; i++)
+        {
+            bool hit = false;
+            steps += kernels[k].trace(scene, origins[i], dirs[i], maxDistance, &hit);
+            hits += hit;
+        }
+        double elapsed = NowSeconds() - start;
+        long long misses = StopCacheMisses();
+
+        AddResult(scene, rays, kernels[k].name, elapsed, steps, misses, hits);
+    }
+
+    for (int i = 0; i < rayCount; i++)
+    {
+        SetBatchRay(batch, i, origins[i], dirs[i], maxDistance);
+    }
+
+    StartCacheMisses();
+    double start = NowSeconds();
+    DDA3DBatch(batch, scene->world);
+    double elapsed = NowSeconds() - start;
+    long long misses = StopCacheMisses();
+
+    int hits = 0;
+    for (int i = 0; i < rayCount; i++)
+    {
+        hits += batch->hit[i];
+    }
+
+    AddResult(scene, rays, "DDA3DBatch", elapsed, -1, misses, hits);
+}
+
+void RunRaySets(const BenchScene *scene, Vector3 *origins, Vector3 *dirs, RayBatch *batch)
+{
+    srand(1);
+    GenRandomRays(scene, origins, dirs);
+    RunKernels(scene, "random", origins, dirs, batch);
+
+    GenCameraRays(scene, origins, dirs);
+    RunKernels(scene, "camera", origins, dirs, batch);
+
+    GenAxisRays(scene, origins, dirs);
+    RunKernels(scene, "axis", origins, dirs, batch);
+
+    GenOutsideRays(scene, origins, dirs);
+    RunKernels(scene, "outside", origins, dirs, batch);
+}
+
+//----------------------------------------------------------------------------------
+// Meshing
+//----------------------------------------------------------------------------------
+typedef struct MeshResult {
+    const char *scene;
+    float density;
+    int size;
+    double voxelsPerSecond;
+    double facesPerVoxel;
+    double cacheMissesPerVoxel; // Negative when no counter is available
+} MeshResult;
+
+MeshResult meshResults[MAX_RESULTS];
+int meshResultCount = 0;
+
+// Exposed faces of the solid voxels of one chunk, looked up through GetWorld like a mesher
+// filling its buffers would
+long long CountChunkFaces(const World *world, int chunk)
+{
+    static const Vector3i normals[6] = { {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1} };
+
+    int n = world->chunksPerSide;
+    if (world->chunks[chunk].bricks == 0) return 0;
+
+    Vector3i base = { (chunk % n)*CHUNK_SIZE, (chunk/n % n)*CHUNK_SIZE, (chunk/(n*n))*CHUNK_SIZE };
+    long long faces = 0;
+    for (int z = base.z; z < base.z + CHUNK_SIZE; z++)
+    {
+        for (int y = base.y; y < base.y + CHUNK_SIZE; y++)
+        {
+            for (int x = base.x; x < base.x + CHUNK_SIZE; x++)
+            {
+                if (!GetWorld((Vector3i){ x, y, z }, world)) continue;
+                for (int f = 0; f < 6; f++)
+                {
+                    if (!GetWorld((Vector3i){ x + normals[f].x, y + normals[f].y, z + normals[f].z }, world)) faces++;
+                }
+            }
+        }
+    }
+    return faces;
+}
+
+void RunMeshing(const BenchScene *scene)
+{
+    const World *world = scene->world;
+    int chunkCount = world->chunksPerSide*world->chunksPerSide*world->chunksPerSide;
+    double voxels = (double)world->size*world->size*world->size;
+
+    StartCacheMisses();
+    double start = NowSeconds();
+    long long faces = 0;
+    for (int i = 0; i < chunkCount; i++)
+    {
+        faces += CountChunkFaces(world, i);
+    }
+    double elapsed = NowSeconds() - start;
+    long long misses = StopCacheMisses();
+
+    if (meshResultCount < MAX_RESULTS)
+    {
+        meshResults[meshResultCount++] = (MeshResult){
+            scene->name, scene->density, world->size, voxels / elapsed, faces / voxels,
+            (misses >= 0) ? misses / voxels : -1.0
+        };
+    }
+}
+
+//----------------------------------------------------------------------------------
+// Thread scaling
+//----------------------------------------------------------------------------------
+typedef struct ScalingResult {
+    int size;
+    int threads;
+    double raysPerSecond;
+    double speedup;
+} ScalingResult;
+
+ScalingResult scaling[MAX_JOB_THREADS];
+int scalingCount = 0;
+
+// Trace the same batch with 1..N job threads against one shared read-only world
+void RunScaling(int size)
+{
+    World world = {0};
+    HeightMap map = LoadHeightMap(size);
+    InitWorld(&world, size);
+    GenTerrainWorld(&world, &map);
+    UnloadHeightMap(&map);
+
+    int count = (rayCount < RAY_COUNT) ? rayCount*10 : SCALING_RAY_COUNT;
+    RayBatch batch = LoadRayBatch(count);
+    srand(2);
+    for (int i = 0; i < count; i++)
+    {
+        Vector3 from = { RandomFloat() * size, size*0.5f + RandomFloat() * size*0.5f, RandomFloat() * size };
+        SetBatchRay(&batch, i, from, RandomDirection(), size * 2.0f);
+    }
+
+    printf("\n%-8s %5s  %8s %10s %10s %8s\n", "scene", "size", "threads", "ms", "Mrays/s", "speedup");
+
+    double baseline = 0;
+    int cpus = GetCpuCount();
+    for (int threads = 1; threads <= cpus; threads = (threads < cpus && threads*2 > cpus) ? cpus : threads*2)
+    {
+        InitJobs(threads);
+
+        RayBatchJob job = { &batch, &world };
+        JobGroup group = {0};
+        double start = NowSeconds();
+        DispatchJobs(&group, TraceRayBatchTile, &job, batch.count, SCALING_TILE_SIZE);
+        WaitJobGroup(&group);
+        double elapsed = NowSeconds() - start;
+
+        UnloadJobs();
+
+        if (threads == 1) baseline = elapsed;
+        scaling[scalingCount++] = (ScalingResult){ size, threads, count / elapsed, baseline / elapsed };
+        printf("%-8s %5d  %8d %10.2f %10.2f %7.2fx\n", "terrain", size, threads,
+            elapsed * 1e3, count / elapsed * 1e-6, baseline / elapsed);
+
+        if (threads == cpus) break;
+    }
+
+    UnloadRayBatch(batch);
+    UnloadWorld(&world);
+}
+
+//----------------------------------------------------------------------------------
+// JSON output
+//----------------------------------------------------------------------------------
+
+// Negative values mean "not measured" and become null
+void WriteJsonNumber(FILE *file, const char *key, double value, const char *separator)
+{
+    if (value < 0) fprintf(file, "\"%s\": null%s", key, separator);
+    else fprintf(file, "\"%s\": %.4f%s", key, value, separator);
+}
+
+bool ExportResults(const char *fileName)
+{
+    FILE *file = fopen(fileName, "w");
+    if (file == NULL) return false;
+
+    fprintf(file, "{\n  \"layout\": \"%s\",\n  \"rayCount\": %d,\n  \"results\": [\n", LAYOUT_NAME, rayCount);
+    for (int i = 0; i < resultCount; i++)
+    {
+        BenchResult r = results[i];
+        fprintf(file, "    { \"scene\": \"%s\", \"density\": %.4f, \"size\": %d, \"rays\": \"%s\", \"kernel\": \"%s\", ",
+            r.scene, r.density, r.size, r.rays, r.kernel);
+        WriteJsonNumber(file, "raysPerSecond", r.raysPerSecond, ", ");
+        WriteJsonNumber(file, "stepsPerRay", r.stepsPerRay, ", ");
+        WriteJsonNumber(file, "cacheMissesPerRay", r.cacheMissesPerRay, ", ");
+        WriteJsonNumber(file, "hitRate", r.hitRate, "");
+        fprintf(file, " }%s\n", (i < resultCount - 1) ? "," : "");
+    }
+    fprintf(file, "  ],\n  \"meshing\": [\n");
+    for (int i = 0; i < meshResultCount; i++)
+    {
+        MeshResult m = meshResults[i];
+        fprintf(file, "    { \"scene\": \"%s\", \"density\": %.4f, \"size\": %d, ", m.scene, m.density, m.size);
+        WriteJsonNumber(file, "voxelsPerSecond", m.voxelsPerSecond, ", ");
+        WriteJsonNumber(file, "facesPerVoxel", m.facesPerVoxel, ", ");
+        WriteJsonNumber(file, "cacheMissesPerVoxel", m.cacheMissesPerVoxel, "");
+        fprintf(file, " }%s\n", (i < meshResultCount - 1) ? "," : "");
+    }
+    fprintf(file, "  ],\n  \"scaling\": [\n");
+    for (int i = 0; i < scalingCount; i++)
+    {
+        ScalingResult s = scaling[i];
+        fprintf(file, "    { \"size\": %d, \"threads\": %d, \"raysPerSecond\": %.1f, \"speedup\": %.3f }%s\n",
+            s.size, s.threads, s.raysPerSecond, s.speedup, (i < scalingCount - 1) ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+
+    bool ok = (ferror(file) == 0);
+    fclose(file);
+    return ok;
+}
+
+bool ExportTerrain(int size, const char *fileName)
+{
+    World world = {0};
+    InitWorld(&world, size);
+    HeightMap map = LoadHeightMap(world.size);
+    GenTerrainWorld(&world, &map);
+    UnloadHeightMap(&map);
+
+    bool ok = ExportWorldStream(&world, fileName);
+    if (ok) printf("%d^3 terrain written to %s, %.1f MB in memory, %.1f MB on disk\n", world.size, fileName,
+        WorldMemoryUsage(&world)/1048576.0, GetFileLength(fileName)/1048576.0);
+    UnloadWorld(&world);
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    const char *jsonFile = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--quick") == 0) rayCount = QUICK_RAY_COUNT;
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) jsonFile = argv[++i];
+        else if (strcmp(argv[i], "--export-world") == 0 && i + 2 < argc) return ExportTerrain(atoi(argv[i + 1]), argv[i + 2]) ? 0 : 1;
+        else
+        {
+            fprintf(stderr, "usage: %s [--quick] [--json results.json]\n       %s --export-world size file\n", argv[0], argv[0]);
+            return 1;
+        }
+    }
+
+    int sizes[] = { 64, 128, 256 };
+    float densities[] = { 0.001f, 0.01f, 0.1f };
+
+    InitCacheMissCounter();
+
+    Vector3 *origins = (Vector3 *)RL_MALLOC(rayCount * sizeof(Vector3));
+    Vector3 *dirs = (Vector3 *)RL_MALLOC(rayCount * sizeof(Vector3));
+    RayBatch batch = LoadRayBatch(rayCount);
+
+    printf("layout %s\n\n", LAYOUT_NAME);
+    printf("%-8s %5s %5s  %-7s %-11s %10s %10s %10s %9s\n", "scene", "dens", "size", "rays", "kernel", "Mrays/s", "steps/ray", "miss/ray", "hits");
+
+    for (int s = 0; s < (int)(sizeof(sizes)/sizeof(sizes[0])); s++)
+    {
+        int size = sizes[s];
+        World world = {0};
+        srand(1);
+
+        InitWorld(&world, size);
+        HeightMap map = LoadHeightMap(size);
+        GenTerrainWorld(&world, &map);
+        BenchScene terrain = { SCENE_TERRAIN, "terrain", 0.0f, &world, &map };
+        RunRaySets(&terrain, origins, dirs, &batch);
+        RunMeshing(&terrain);
+        UnloadHeightMap(&map);
+        UnloadWorld(&world);
+
+        for (int d = 0; d < (int)(sizeof(densities)/sizeof(densities[0])); d++)
+        {
+            InitWorld(&world, size);
+            GenScatterWorld(&world, densities[d]);
+            BenchScene scatter = { SCENE_SCATTER, "scatter", densities[d], &world, NULL };
+            RunRaySets(&scatter, origins, dirs, &batch);
+            RunMeshing(&scatter);
+            UnloadWorld(&world);
+        }
+    }
+
+    RL_FREE(origins);
+    RL_FREE(dirs);
+    UnloadRayBatch(batch);
+
+    printf("\n%-8s %5s %5s  %12s %10s %10s\n", "scene", "dens", "size", "Mvoxels/s", "faces/vox", "miss/vox");
+    for (int i = 0; i < meshResultCount; i++)
+    {
+        MeshResult m = meshResults[i];
+        char missText[16] = "-";
+        if (m.cacheMissesPerVoxel >= 0) snprintf(missText, sizeof(missText), "%.4f", m.cacheMissesPerVoxel);
+        printf("%-8s %5.3f %5d  %12.2f %10.4f %10s\n", m.scene, m.density, m.size,
+            m.voxelsPerSecond * 1e-6, m.facesPerVoxel, missText);
+    }
+
+    RunScaling(256);
+
+    if (jsonFile != NULL)
+    {
+        if (ExportResults(jsonFile)) printf("\nresults written to %s\n", jsonFile);
+        else fprintf(stderr, "could not write %s\n", jsonFile);
+    }
+
+    return 0;
+}
@@ -0,0 +1,263 @@
+/**********************************************************************************************
+*
+*   cull - Frustum and flood fill occlusion culling of World chunks
+*
+*   GetCameraFrustum builds the six planes of the view volume BeginMode3D sets up for a
+*   Camera3D, and IsBoxInFrustum tests a box against them (conservatively, a box that only
+*   straddles the corner of two planes still counts as inside).
+*
+*   UpdateChunkVisibility decides, once per frame, which chunks of a World may be drawn:
+*
+*     - Frustum: chunks whose box is outside the view volume are dropped.
+*     - Occlusion: a flood fill starts at the camera's chunk (or at the world faces turned
+*       towards a camera outside the world) and crosses chunk faces only away from the camera,
+*       so it follows every line of sight. Completely solid chunks are reached but not crossed,
+*       everything behind them that no other path reaches is occluded. This is coarse, mixed
+*       chunks never occlude, but it is exact about what it does cull and costs one pass over
+*       the chunks in view.
+*     - Empty: reached chunks without a single non-zero brick have nothing to draw. Unknown
+*       chunks (not streamed in yet) are kept, the caller decides how to show them, and
+*       never occlude.
+*
+*   The rest end up in visible[], the draw loop walks only those. The counts of every class
+*   are kept for the profiler. Only the World types are used, the frustum half works without
+*   a World at all.
+*
+*   CONFIGURATION:
+*
+*   #define CULL_IMPLEMENTATION
+*       Generates the implementation of the library into the included file.
+*       Only ONE file should hold the implementation.
+*
+**********************************************************************************************/
+
+#ifndef CULL_H
+#define CULL_H
+
+#include "raylib.h"
+#include "world.h"
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define CULL_NEAR   0.01                // Clip planes of BeginMode3D (RL_CULL_DISTANCE_NEAR/FAR)
+#define CULL_FAR    1000.0
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct Frustum {
+    Vector4 planes[6];          // Inside where x*p.x + y*p.y + z*p.z + w >= 0
+} Frustum;
+
+typedef struct ChunkVisibility {
+    int chunkCount;
+    unsigned char *visible;     // Per chunk: 1 when it should be drawn
+    int *visibleList;           // Indices of the visible chunks, visibleCount of them
+    int visibleCount;
+    int frustumCulled;          // Outside the view volume
+    int occlusionCulled;        // In view, but no line of sight reaches it
+    int emptyCulled;            // Reached, but nothing to draw
+    unsigned char *reached;     // Flood fill scratch
+    int *queue;
+} ChunkVisibility;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+Frustum GetCameraFrustum(Camera3D camera, float aspect);    // View volume of BeginMode3D, aspect is width/height of the target
+bool IsBoxInFrustum(const Frustum *frustum, BoundingBox box);
+ChunkVisibility LoadChunkVisibility(const World *world);
+void UnloadChunkVisibility(ChunkVisibility *visibility);
+void UpdateChunkVisibility(ChunkVisibility *visibility, const World *world, Camera3D camera, float aspect);
+BoundingBox GetChunkBox(const World *world, int chunk);      // Voxel bounds of a chunk, clipped to the world
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CULL_H
+
+/***********************************************************************************
+*
+*   CULL IMPLEMENTATION
+*
+************************************************************************************/
+
+#if defined(CULL_IMPLEMENTATION) && !defined(CULL_IMPLEMENTED)
+#define CULL_IMPLEMENTED
+
+#include "raymath.h"
+
+Frustum GetCameraFrustum(Camera3D camera, float aspect)
+{
+    Matrix view = MatrixLookAt(camera.position, camera.target, camera.up);
+    Matrix projection;
+    if (camera.projection == CAMERA_PERSPECTIVE)
+    {
+        projection = MatrixPerspective(camera.fovy*DEG2RAD, aspect, CULL_NEAR, CULL_FAR);
+    }
+    else
+    {
+        double top = camera.fovy/2.0;
+        double right = top*aspect;
+        projection = MatrixOrtho(-right, right, -top, top, CULL_NEAR, CULL_FAR);
+    }
+
+    // Rows of the combined matrix, the planes are w +- x, w +- y and w +- z in clip space
+    Matrix m = MatrixMultiply(view, projection);
+    Vector4 rows[4] = {
+        { m.m0, m.m4, m.m8, m.m12 },
+        { m.m1, m.m5, m.m9, m.m13 },
+        { m.m2, m.m6, m.m10, m.m14 },
+        { m.m3, m.m7, m.m11, m.m15 },
+    };
+
+    Frustum frustum = { 0 };
+    for (int i = 0; i < 6; i++)
+    {
+        Vector4 r = rows[i/2];
+        float s = (i & 1) ? -1.0f : 1.0f;
+        frustum.planes[i] = (Vector4){ rows[3].x + s*r.x, rows[3].y + s*r.y, rows[3].z + s*r.z, rows[3].w + s*r.w };
+    }
+    return frustum;
+}
+
+bool IsBoxInFrustum(const Frustum *frustum, BoundingBox box)
+{
+    for (int i = 0; i < 6; i++)
+    {
+        // Corner of the box furthest along the plane normal
+        Vector4 p = frustum->planes[i];
+        float x = (p.x >= 0) ? box.max.x : box.min.x;
+        float y = (p.y >= 0) ? box.max.y : box.min.y;
+        float z = (p.z >= 0) ? box.max.z : box.min.z;
+        if (p.x*x + p.y*y + p.z*z + p.w < 0) return false;
+    }
+    return true;
+}
+
+ChunkVisibility LoadChunkVisibility(const World *world)
+{
+    ChunkVisibility visibility = { 0 };
+    int n = world->chunksPerSide;
+    visibility.chunkCount = n*n*n;
+    visibility.visible = (unsigned char *)RL_CALLOC(visibility.chunkCount, 1);
+    visibility.visibleList = (int *)RL_MALLOC(visibility.chunkCount*sizeof(int));
+    visibility.reached = (unsigned char *)RL_CALLOC(visibility.chunkCount, 1);
+    visibility.queue = (int *)RL_MALLOC(visibility.chunkCount*sizeof(int));
+    return visibility;
+}
+
+void UnloadChunkVisibility(ChunkVisibility *visibility)
+{
+    RL_FREE(visibility->visible);
+    RL_FREE(visibility->visibleList);
+    RL_FREE(visibility->reached);
+    RL_FREE(visibility->queue);
+    *visibility = (ChunkVisibility){ 0 };
+}
+
+BoundingBox GetChunkBox(const World *world, int chunk)
+{
+    int n = world->chunksPerSide;
+    Vector3 min = { (float)((chunk % n)*CHUNK_SIZE), (float)((chunk/n % n)*CHUNK_SIZE), (float)((chunk/(n*n))*CHUNK_SIZE) };
+    Vector3 max = { fminf(min.x + CHUNK_SIZE, (float)world->size), fminf(min.y + CHUNK_SIZE, (float)world->size), fminf(min.z + CHUNK_SIZE, (float)world->size) };
+    return (BoundingBox){ min, max };
+}
+
+void UpdateChunkVisibility(ChunkVisibility *visibility, const World *world, Camera3D camera, float aspect)
+{
+    int n = world->chunksPerSide;
+    Frustum frustum = GetCameraFrustum(camera, aspect);
+    Vector3 eye = camera.position;
+    float size = (float)world->size;
+    bool inside = (eye.x >= 0 && eye.y >= 0 && eye.z >= 0 && eye.x < size && eye.y < size && eye.z < size);
+
+    visibility->visibleCount = 0;
+    visibility->frustumCulled = 0;
+    visibility->occlusionCulled = 0;
+    visibility->emptyCulled = 0;
+
+    // Frustum first, the fill only runs through chunks in view. reached: 0 culled,
+    // 1 in view, 2 queued
+    int head = 0, tail = 0, start = -1;
+    for (int i = 0; i < visibility->chunkCount; i++)
+    {
+        visibility->visible[i] = 0;
+        visibility->reached[i] = IsBoxInFrustum(&frustum, GetChunkBox(world, i)) ? 1 : 0;
+        if (!visibility->reached[i]) visibility->frustumCulled++;
+
+        // A camera outside sees in through the world faces turned towards it
+        int c[3] = { i % n, i/n % n, i/(n*n) };
+        float e[3] = { eye.x, eye.y, eye.z };
+        bool seed = false;
+        for (int a = 0; a < 3 && !inside; a++)
+        {
+            if ((c[a] == 0 && e[a] < 0) || (c[a] == n - 1 && e[a] >= size)) seed = true;
+        }
+        if (seed && visibility->reached[i])
+        {
+            visibility->reached[i] = 2;
+            visibility->queue[tail++] = i;
+        }
+    }
+
+    if (inside)
+    {
+        // The camera's own chunk can fail the near plane, it is always in
+        start = (((int)eye.z >> CHUNK_BITS)*n + ((int)eye.y >> CHUNK_BITS))*n + ((int)eye.x >> CHUNK_BITS);
+        if (!visibility->reached[start]) visibility->frustumCulled--;
+        visibility->reached[start] = 2;
+        visibility->queue[tail++] = start;
+    }
+
+    while (head < tail)
+    {
+        int i = visibility->queue[head++];
+        const Chunk *chunk = &world->chunks[i];
+
+        if (chunk->bricks == 0 && !chunk->unknown) visibility->emptyCulled++;
+        else
+        {
+            visibility->visible[i] = 1;
+            visibility->visibleList[visibility->visibleCount++] = i;
+        }
+
+        // Solid chunks are drawn but nothing is seen through them, except from inside
+        // (or from the face of) the camera's own chunk
+        if (chunk->bits == 0 && chunk->value != 0 && i != start) continue;
+
+        int c[3] = { i % n, i/n % n, i/(n*n) };
+        float e[3] = { eye.x, eye.y, eye.z };
+        int stride[3] = { 1, n, n*n };
+        for (int a = 0; a < 3; a++)
+        {
+            for (int step = -1; step <= 1; step += 2)
+            {
+                int next = c[a] + step;
+                if (next < 0 || next >= n) continue;
+
+                // Only cross faces that lie beyond the camera along the step
+                float face = (float)((step > 0) ? next : c[a])*CHUNK_SIZE;
+                if ((step > 0) ? (face < e[a]) : (face > e[a])) continue;
+
+                int j = i + step*stride[a];
+                if (visibility->reached[j] != 1) continue;
+                visibility->reached[j] = 2;
+                visibility->queue[tail++] = j;
+            }
+        }
+    }
+
+    for (int i = 0; i < visibility->chunkCount; i++)
+    {
+        if (visibility->reached[i] == 1) visibility->occlusionCulled++;
+    }
+}
+
+#endif // CULL_IMPLEMENTATION
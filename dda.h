@@ -0,0 +1,732 @@
+/**********************************************************************************************
+*
+*   dda - Voxel ray traversal kernels
+*
+*   Headless versions of the dda3 walks: no drawing, no globals, they only read the world.
+*   DDA3DFlat steps one voxel at a time (Amanatides & Woo). DDA3DBrick uses the world's
+*   chunk and brick occupancy to jump over whole empty chunks and 4^3 bricks, and inside an
+*   occupied brick steps per voxel against the brick's 64 bit occupancy word, one shift and
+*   mask per voxel with no palette lookups.
+*
+*   DDA3DBatch traces many rays stored as structure of arrays, one DDA3DBrick walk per ray.
+*   With DDA_SIMD_PACKETS rays instead move through the same chunk/brick/voxel hierarchy in
+*   packets of 8 with the stepping math in SIMD registers (AVX2 when the CPU has it, SSE2
+*   otherwise). The packets lose to DDA3DBrick in bench.c: lanes diverge after a few cells
+*   and the occupancy lookup stays scalar per lane, so they are off by default.
+*
+*   DDA2DWalk, DDAXWalk and DDA3DWalk are the geometry of the dda3 debug views without the
+*   drawing: they only report the boundary crossings of a ray and never look at a world.
+*
+*   The world reading kernels first clip every ray to the world box [0, size]^3: a ray
+*   starting outside begins at the point where it enters (its distances still count from
+*   the original origin), one that misses the box, or only reaches it beyond maxDistance,
+*   returns without a step. A query costs its length inside the world, wherever it starts.
+*
+*   Chunks that are not in memory (Chunk.unknown, see stream.h) end a ray without an answer:
+*   it reports unknown along with the cell and distance where it reached such a chunk, so a
+*   caller can retry later instead of the walk waiting for a load.
+*
+*   None of the kernels write to the world, so any number of threads may trace against the
+*   same World as long as nobody modifies it meanwhile (see SyncWorld for snapshots).
+*   TraceRayBatchTile matches the jobs.h JobFunc signature for splitting a batch into tiles.
+*
+*   CONFIGURATION:
+*
+*   #define DDA_IMPLEMENTATION
+*       Generates the implementation of the library into the included file.
+*       Only ONE file should hold the implementation.
+*
+*   #define DDA_SIMD_PACKETS
+*       Trace batches in SIMD packets of 8 rays (GCC/Clang on x86 only) instead of
+*       one DDA3DBrick walk per ray.
+*
+**********************************************************************************************/
+
+#ifndef DDA_H
+#define DDA_H
+
+#include "raylib.h"
+#include "world.h"
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+
+// Face of the hit voxel the ray entered through
+typedef enum {
+    FACE_NONE = -1,         // Ray started inside a solid voxel
+    FACE_POS_X = 0,
+    FACE_NEG_X,
+    FACE_POS_Y,
+    FACE_NEG_Y,
+    FACE_POS_Z,
+    FACE_NEG_Z
+} VoxelFace;
+
+typedef struct RayHit {
+    bool hit;               // Ray hit a non-zero voxel
+    bool unknown;           // Ray stopped at a chunk that isn't in memory, voxel is its first cell
+    Vector3i voxel;         // Hit voxel
+    int face;               // VoxelFace entered through
+    float distance;         // Distance along the ray to the hit
+    int steps;              // Cells (voxels, bricks or chunks) visited
+} RayHit;
+
+// Rays in, hits out, one array entry per ray
+typedef struct RayBatch {
+    int count;
+    float *originX, *originY, *originZ;
+    float *dirX, *dirY, *dirZ;          // Normalized directions
+    float *maxDistance;
+
+    unsigned char *hit;
+    unsigned char *unknown;
+    int *voxelX, *voxelY, *voxelZ;
+    int *face;
+    float *distance;
+} RayBatch;
+
+// Job data for TraceRayBatchTile
+typedef struct RayBatchJob {
+    RayBatch *batch;
+    const World *world;
+} RayBatchJob;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+RayHit DDA3DFlat(Vector3 from, Vector3 dir, float maxDistance, const World *world);     // Per voxel walk, dir must be normalized
+RayHit DDA3DBrick(Vector3 from, Vector3 dir, float maxDistance, const World *world);    // Walk skipping empty chunks and bricks
+
+int DDA2DWalk(Vector2 from, Vector2 dir, float maxDistance, Vector2 *points, int maxPoints);  // Grid line crossings up to maxDistance, returns how many, stores the first maxPoints
+int DDAXWalk(Vector3 from, Vector3 dir, float bound, int maxSteps, Vector3 *points, Vector3i *cells);  // Next integer plane per step until a coordinate reaches bound, points/cells hold maxSteps
+int DDA3DWalk(Vector3 from, Vector3 dir, float maxDistance, Vector3 *points, Vector3i *cells, int maxPoints); // Voxel boundary crossings up to maxDistance, returns how many
+
+RayBatch LoadRayBatch(int count);                                           // Allocate arrays for count rays
+void UnloadRayBatch(RayBatch batch);
+void SetBatchRay(RayBatch *batch, int i, Vector3 from, Vector3 dir, float maxDistance);
+RayHit GetBatchHit(const RayBatch *batch, int i);                           // Result of ray i (steps not tracked)
+void DDA3DBatch(RayBatch *batch, const World *world);                       // Trace every ray in the batch
+void DDA3DBatchRange(RayBatch *batch, int begin, int end, const World *world); // Trace rays [begin, end)
+void TraceRayBatchTile(void *data, int begin, int end);                     // RayBatchJob data, for DispatchJobs
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DDA_H
+
+/***********************************************************************************
+*
+*   DDA IMPLEMENTATION
+*
+************************************************************************************/
+
+#if defined(DDA_IMPLEMENTATION) && !defined(DDA_IMPLEMENTED)
+#define DDA_IMPLEMENTED
+
+#include <math.h>
+
+// Per axis traversal state shared by both walks
+typedef struct DDAState {
+    float origin[3];
+    float dir[3];
+    float invDir[3];        // 1/dir, +-INFINITY for axis parallel rays
+    int step[3];
+} DDAState;
+
+static DDAState DDAInit(Vector3 from, Vector3 dir)
+{
+    DDAState s;
+    float o[3] = { from.x, from.y, from.z };
+    float d[3] = { dir.x, dir.y, dir.z };
+
+    for (int a = 0; a < 3; a++)
+    {
+        s.origin[a] = o[a];
+        s.dir[a] = d[a];
+        s.step[a] = d[a] < 0 ? -1 : 1;
+        s.invDir[a] = d[a] != 0 ? 1.0f / d[a] : (float)s.step[a] * INFINITY;
+    }
+
+    return s;
+}
+
+// Distance along the ray to the next boundary of cell c along axis a
+static inline float DDABoundary(const DDAState *s, int a, int c)
+{
+    float boundary = (float)(s->step[a] > 0 ? c + 1 : c);
+    return (boundary - s->origin[a]) * s->invDir[a];
+}
+
+static inline bool DDAInside(const int c[3], const World *world)
+{
+    return (unsigned)c[0] < (unsigned)world->size &&
+           (unsigned)c[1] < (unsigned)world->size &&
+           (unsigned)c[2] < (unsigned)world->size;
+}
+
+// Clip the ray to the world box (slab test). On success c is the first cell inside,
+// distance where the ray enters (0 when it starts inside) and face the face it entered
+// through. False when the box is missed or only reached beyond maxDistance
+static bool DDAEnterWorld(const DDAState *s, const World *world, float maxDistance, int c[3], float *distance, int *face)
+{
+    float size = (float)world->size;
+    float enter = 0.0f, leave = maxDistance;
+    int axis = -1;
+
+    for (int a = 0; a < 3; a++)
+    {
+        if (s->dir[a] == 0)
+        {
+            if (s->origin[a] < 0 || s->origin[a] >= size) return false;
+            continue;
+        }
+
+        float t0 = (0.0f - s->origin[a]) * s->invDir[a];
+        float t1 = (size - s->origin[a]) * s->invDir[a];
+        if (t0 > t1)
+        {
+            float t = t0;
+            t0 = t1;
+            t1 = t;
+        }
+        if (t0 > enter)
+        {
+            enter = t0;
+            axis = a;
+        }
+        if (t1 < leave) leave = t1;
+    }
+    if (enter > leave) return false;
+
+    // Rounding can put the entry point a hair outside, the cell is clamped back in
+    for (int a = 0; a < 3; a++)
+    {
+        int v = (int)floorf(s->origin[a] + enter * s->dir[a]);
+        c[a] = v < 0 ? 0 : (v > world->size - 1 ? world->size - 1 : v);
+    }
+    *distance = enter;
+    *face = (axis < 0) ? FACE_NONE : axis*2 + (s->step[axis] > 0 ? 1 : 0);
+    return true;
+}
+
+RayHit DDA3DFlat(Vector3 from, Vector3 dir, float maxDistance, const World *world)
+{
+    RayHit result = { .hit = false, .face = FACE_NONE };
+    DDAState s = DDAInit(from, dir);
+
+    int c[3];
+    float distance = 0.0f;
+    if (!DDAEnterWorld(&s, world, maxDistance, c, &distance, &result.face)) return result;
+
+    float tMax[3], tDelta[3];
+    for (int a = 0; a < 3; a++)
+    {
+        tMax[a] = DDABoundary(&s, a, c[a]);
+        tDelta[a] = fabsf(s.invDir[a]);
+    }
+
+    while (DDAInside(c, world))
+    {
+        result.steps++;
+
+        Vector3i p = { c[0], c[1], c[2] };
+        const Chunk *chunk = &world->chunks[WorldIndex(p, world)];
+        if (chunk->unknown || GetChunkVoxel(chunk, ChunkVoxelIndex(p)))
+        {
+            result.hit = !chunk->unknown;
+            result.unknown = chunk->unknown;
+            result.voxel = p;
+            result.distance = distance;
+            return result;
+        }
+
+        // Walk along shortest path
+        int a = (tMax[0] < tMax[1]) ? (tMax[0] < tMax[2] ? 0 : 2) : (tMax[1] < tMax[2] ? 1 : 2);
+        distance = tMax[a];
+        if (distance > maxDistance) break;
+
+        c[a] += s.step[a];
+        tMax[a] += tDelta[a];
+        result.face = a*2 + (s.step[a] > 0 ? 1 : 0);
+    }
+
+    return result;
+}
+
+RayHit DDA3DBrick(Vector3 from, Vector3 dir, float maxDistance, const World *world)
+{
+    RayHit result = { .hit = false, .face = FACE_NONE };
+    DDAState s = DDAInit(from, dir);
+
+    int c[3];
+    float distance = 0.0f;
+    if (!DDAEnterWorld(&s, world, maxDistance, c, &distance, &result.face)) return result;
+
+    while (DDAInside(c, world))
+    {
+        result.steps++;
+
+        Vector3i p = { c[0], c[1], c[2] };
+        const Chunk *chunk = &world->chunks[WorldIndex(p, world)];
+
+        if (chunk->unknown)
+        {
+            result.unknown = true;
+            result.voxel = p;
+            result.distance = distance;
+            return result;
+        }
+
+        int size = 0;
+        if (!chunk->bricks) size = CHUNK_SIZE;
+        else if (!(chunk->bricks & (1ull << ChunkBrickIndex(p)))) size = BRICK_SIZE;
+
+        if (size)
+        {
+            // Empty chunk or brick: leave it through whichever face the ray reaches first
+            int lo[3], a = 0;
+            float exit = INFINITY;
+            for (int i = 0; i < 3; i++)
+            {
+                lo[i] = c[i] & ~(size - 1);
+                float t = DDABoundary(&s, i, s.step[i] > 0 ? lo[i] + size - 1 : lo[i]);
+                if (t < exit)
+                {
+                    exit = t;
+                    a = i;
+                }
+            }
+
+            distance = exit;
+            if (distance > maxDistance) break;
+
+            for (int i = 0; i < 3; i++)
+            {
+                if (i == a)
+                {
+                    c[i] = s.step[i] > 0 ? lo[i] + size : lo[i] - 1;
+                }
+                else
+                {
+                    // Clamp so rounding can't move us sideways out of the box we just left
+                    int v = (int)floorf(s.origin[i] + distance * s.dir[i]);
+                    c[i] = v < lo[i] ? lo[i] : (v > lo[i] + size - 1 ? lo[i] + size - 1 : v);
+                }
+            }
+            result.face = a*2 + (s.step[a] > 0 ? 1 : 0);
+            continue;
+        }
+
+        // Occupied brick: walk its occupancy word until we hit something or leave the brick
+        uint64_t occupancy = GetBrickOccupancy(chunk, ChunkBrickIndex(p));
+        int lo[3];
+        float tMax[3], tDelta[3];
+        for (int i = 0; i < 3; i++)
+        {
+            lo[i] = c[i] & ~BRICK_MASK;
+            tMax[i] = DDABoundary(&s, i, c[i]);
+            tDelta[i] = fabsf(s.invDir[i]);
+        }
+
+        while (true)
+        {
+            if ((occupancy >> BrickVoxelBit((Vector3i){ c[0], c[1], c[2] })) & 1)
+            {
+                result.hit = true;
+                result.voxel = (Vector3i){ c[0], c[1], c[2] };
+                result.distance = distance;
+                return result;
+            }
+
+            int a = (tMax[0] < tMax[1]) ? (tMax[0] < tMax[2] ? 0 : 2) : (tMax[1] < tMax[2] ? 1 : 2);
+            distance = tMax[a];
+            if (distance > maxDistance) return result;
+
+            c[a] += s.step[a];
+            tMax[a] += tDelta[a];
+            result.face = a*2 + (s.step[a] > 0 ? 1 : 0);
+
+            if ((c[a] & ~BRICK_MASK) != lo[a]) break;
+            result.steps++;
+        }
+    }
+
+    return result;
+}
+
+//----------------------------------------------------------------------------------
+// Debug walks
+//----------------------------------------------------------------------------------
+
+int DDA2DWalk(Vector2 from, Vector2 dir, float maxDistance, Vector2 *points, int maxPoints)
+{
+    int cellX = (int)floorf(from.x);
+    int cellY = (int)floorf(from.y);
+
+    // Distance along the ray between two crossings of the same axis
+    float unitX = (dir.x != 0) ? fabsf(1.0f / dir.x) : INFINITY;
+    float unitY = (dir.y != 0) ? fabsf(1.0f / dir.y) : INFINITY;
+    float lengthX = (dir.x != 0) ? ((dir.x < 0) ? from.x - cellX : cellX + 1.0f - from.x) * unitX : INFINITY;
+    float lengthY = (dir.y != 0) ? ((dir.y < 0) ? from.y - cellY : cellY + 1.0f - from.y) * unitY : INFINITY;
+
+    int steps = 0;
+    for (;;)
+    {
+        float distance;
+        if (lengthX < lengthY)
+        {
+            distance = lengthX;
+            lengthX += unitX;
+        }
+        else
+        {
+            distance = lengthY;
+            lengthY += unitY;
+        }
+        if (distance >= maxDistance) break;
+
+        if (points != NULL && steps < maxPoints) points[steps] = (Vector2){ from.x + dir.x*distance, from.y + dir.y*distance };
+        steps++;
+    }
+
+    return steps;
+}
+
+// Jumps to the nearest next integer plane of the three axes. Only meant for directions
+// with positive components, maxSteps stops the others
+int DDAXWalk(Vector3 from, Vector3 dir, float bound, int maxSteps, Vector3 *points, Vector3i *cells)
+{
+    Vector3 pos = from;
+
+    int steps = 0;
+    while (pos.x < bound && pos.y < bound && pos.z < bound && steps < maxSteps)
+    {
+        // How far to travel along dir to reach the next plane of each axis
+        float distX = ((int)pos.x + 1 - pos.x) / dir.x;
+        float distY = ((int)pos.y + 1 - pos.y) / dir.y;
+        float distZ = ((int)pos.z + 1 - pos.z) / dir.z;
+
+        float dist = distZ;
+        if (distX <= distY && distX <= distZ) dist = distX;
+        else if (distY <= distX && distY <= distZ) dist = distY;
+
+        pos = (Vector3){ pos.x + dir.x*dist, pos.y + dir.y*dist, pos.z + dir.z*dist };
+
+        if (points != NULL) points[steps] = pos;
+        if (cells != NULL) cells[steps] = (Vector3i){ (int)pos.x, (int)pos.y, (int)pos.z };
+        steps++;
+    }
+
+    return steps;
+}
+
+int DDA3DWalk(Vector3 from, Vector3 dir, float maxDistance, Vector3 *points, Vector3i *cells, int maxPoints)
+{
+    DDAState s = DDAInit(from, dir);
+
+    int c[3] = { (int)floorf(from.x), (int)floorf(from.y), (int)floorf(from.z) };
+    float tMax[3], tDelta[3];
+    for (int a = 0; a < 3; a++)
+    {
+        tMax[a] = DDABoundary(&s, a, c[a]);
+        tDelta[a] = fabsf(s.invDir[a]);
+    }
+
+    int steps = 0;
+    for (;;)
+    {
+        int a = (tMax[0] < tMax[1]) ? (tMax[0] < tMax[2] ? 0 : 2) : (tMax[1] < tMax[2] ? 1 : 2);
+        float distance = tMax[a];
+        if (distance >= maxDistance) break;
+
+        c[a] += s.step[a];
+        tMax[a] += tDelta[a];
+
+        if (steps < maxPoints)
+        {
+            if (points != NULL) points[steps] = (Vector3){ from.x + dir.x*distance, from.y + dir.y*distance, from.z + dir.z*distance };
+            if (cells != NULL) cells[steps] = (Vector3i){ c[0], c[1], c[2] };
+        }
+        steps++;
+    }
+
+    return steps;
+}
+
+//----------------------------------------------------------------------------------
+// Batched traversal
+//----------------------------------------------------------------------------------
+
+RayBatch LoadRayBatch(int count)
+{
+    RayBatch batch = { .count = count };
+    batch.originX = (float *)RL_MALLOC(count * sizeof(float));
+    batch.originY = (float *)RL_MALLOC(count * sizeof(float));
+    batch.originZ = (float *)RL_MALLOC(count * sizeof(float));
+    batch.dirX = (float *)RL_MALLOC(count * sizeof(float));
+    batch.dirY = (float *)RL_MALLOC(count * sizeof(float));
+    batch.dirZ = (float *)RL_MALLOC(count * sizeof(float));
+    batch.maxDistance = (float *)RL_MALLOC(count * sizeof(float));
+    batch.hit = (unsigned char *)RL_MALLOC(count * sizeof(unsigned char));
+    batch.unknown = (unsigned char *)RL_MALLOC(count * sizeof(unsigned char));
+    batch.voxelX = (int *)RL_MALLOC(count * sizeof(int));
+    batch.voxelY = (int *)RL_MALLOC(count * sizeof(int));
+    batch.voxelZ = (int *)RL_MALLOC(count * sizeof(int));
+    batch.face = (int *)RL_MALLOC(count * sizeof(int));
+    batch.distance = (float *)RL_MALLOC(count * sizeof(float));
+    return batch;
+}
+
+void UnloadRayBatch(RayBatch batch)
+{
+    RL_FREE(batch.originX);
+    RL_FREE(batch.originY);
+    RL_FREE(batch.originZ);
+    RL_FREE(batch.dirX);
+    RL_FREE(batch.dirY);
+    RL_FREE(batch.dirZ);
+    RL_FREE(batch.maxDistance);
+    RL_FREE(batch.hit);
+    RL_FREE(batch.unknown);
+    RL_FREE(batch.voxelX);
+    RL_FREE(batch.voxelY);
+    RL_FREE(batch.voxelZ);
+    RL_FREE(batch.face);
+    RL_FREE(batch.distance);
+}
+
+void SetBatchRay(RayBatch *batch, int i, Vector3 from, Vector3 dir, float maxDistance)
+{
+    batch->originX[i] = from.x;
+    batch->originY[i] = from.y;
+    batch->originZ[i] = from.z;
+    batch->dirX[i] = dir.x;
+    batch->dirY[i] = dir.y;
+    batch->dirZ[i] = dir.z;
+    batch->maxDistance[i] = maxDistance;
+}
+
+RayHit GetBatchHit(const RayBatch *batch, int i)
+{
+    RayHit result = {0};
+    result.hit = batch->hit[i];
+    result.unknown = batch->unknown[i];
+    result.voxel = (Vector3i){ batch->voxelX[i], batch->voxelY[i], batch->voxelZ[i] };
+    result.face = batch->face[i];
+    result.distance = batch->distance[i];
+    return result;
+}
+
+#if defined(DDA_SIMD_PACKETS) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+// Size of the empty cell around p that a ray may skip: a whole chunk, a brick,
+// a single voxel, 0 when the voxel itself is solid or -1 in an unknown chunk
+static int DDACellSize(Vector3i p, const World *world)
+{
+    const Chunk *chunk = &world->chunks[WorldIndex(p, world)];
+    if (!chunk->bricks) return chunk->unknown ? -1 : CHUNK_SIZE;
+    if (!(chunk->bricks & (1ull << ChunkBrickIndex(p)))) return BRICK_SIZE;
+    return ((GetBrickOccupancy(chunk, ChunkBrickIndex(p)) >> BrickVoxelBit(p)) & 1) ? 0 : 1;
+}
+
+#define DDA_LANES 8
+
+typedef float v8f __attribute__((vector_size(32)));
+typedef int v8i __attribute__((vector_size(32)));
+typedef unsigned int v8u __attribute__((vector_size(32)));
+
+// Pick a where mask is set, b elsewhere
+#define DDA_SELECT(mask, a, b) (((mask) & (a)) | (~(mask) & (b)))
+#define DDA_SELECTF(mask, a, b) ((v8f)DDA_SELECT((mask), (v8i)(a), (v8i)(b)))
+
+// Vectors go through pointers so the helper doesn't get a 256 bit ABI of its own
+static inline __attribute__((always_inline)) void DDAFloor(const v8f *v, v8i *out)
+{
+    v8i i = __builtin_convertvector(*v, v8i);
+    *out = i + (__builtin_convertvector(i, v8f) > *v);  // true lanes are -1
+}
+
+// Trace one packet of up to 8 rays starting at ray base. Every lane advances one
+// cell per iteration, where a cell is whatever DDACellSize says it may skip.
+// Compiled once per instruction set by the wrappers below.
+static inline __attribute__((always_inline)) void DDA3DPacket(RayBatch *batch, int base, int lanes, const World *world)
+{
+    const float *origins[3] = { batch->originX, batch->originY, batch->originZ };
+    const float *dirs[3] = { batch->dirX, batch->dirY, batch->dirZ };
+
+    v8f o[3], d[3], inv[3], maxDistance = {0};
+    v8i step[3], c[3], active = {0};
+    v8f inf = { INFINITY, INFINITY, INFINITY, INFINITY, INFINITY, INFINITY, INFINITY, INFINITY };
+
+    for (int a = 0; a < 3; a++)
+    {
+        o[a] = (v8f){0};
+        d[a] = (v8f){0};
+        for (int l = 0; l < lanes; l++)
+        {
+            o[a][l] = origins[a][base + l];
+            d[a][l] = dirs[a][base + l];
+        }
+
+        step[a] = (d[a] < 0) | 1;
+        inv[a] = DDA_SELECTF(d[a] == 0, inf, 1.0f / d[a]);
+        c[a] = (v8i){0};
+    }
+
+    // Clip each lane to the world box, lanes that miss it start inactive
+    v8f distance = {0};
+    v8i face = { FACE_NONE, FACE_NONE, FACE_NONE, FACE_NONE, FACE_NONE, FACE_NONE, FACE_NONE, FACE_NONE };
+    for (int l = 0; l < lanes; l++)
+    {
+        maxDistance[l] = batch->maxDistance[base + l];
+        DDAState s = DDAInit((Vector3){ o[0][l], o[1][l], o[2][l] }, (Vector3){ d[0][l], d[1][l], d[2][l] });
+        int cell[3];
+        float enter = 0.0f;
+        int entered = FACE_NONE;
+        if (!DDAEnterWorld(&s, world, maxDistance[l], cell, &enter, &entered)) continue;
+
+        for (int a = 0; a < 3; a++)
+        {
+            c[a][l] = cell[a];
+        }
+        distance[l] = enter;
+        face[l] = entered;
+        active[l] = -1;
+    }
+
+    v8i hit = {0}, unknown = {0};
+    v8u size = (v8u)(v8i){0} + (unsigned)world->size;
+
+    while (true)
+    {
+        active &= ((v8u)c[0] < size) & ((v8u)c[1] < size) & ((v8u)c[2] < size);
+
+        int any = 0;
+        v8i cell = {0};
+        for (int l = 0; l < DDA_LANES; l++)
+        {
+            if (!active[l]) continue;
+            any = 1;
+            cell[l] = DDACellSize((Vector3i){ c[0][l], c[1][l], c[2][l] }, world);
+        }
+        if (!any) break;
+
+        v8i solid = active & (cell == 0);
+        v8i stopped = active & (cell < 0);
+        hit |= solid;
+        unknown |= stopped;
+        active &= ~solid & ~stopped;
+
+        // Leave the cell through whichever face the ray reaches first
+        v8i lo[3];
+        v8f t[3];
+        for (int a = 0; a < 3; a++)
+        {
+            lo[a] = c[a] & ~(cell - 1);
+            v8i boundary = DDA_SELECT(step[a] > 0, lo[a] + cell, lo[a]);
+            t[a] = (__builtin_convertvector(boundary, v8f) - o[a]) * inv[a];
+        }
+
+        v8i x01 = t[0] < t[1];
+        v8i axis0 = x01 & (t[0] < t[2]);
+        v8i axis1 = ~x01 & (t[1] < t[2]);
+        v8i axis2 = ~axis0 & ~axis1;
+        v8f exit = DDA_SELECTF(axis0, t[0], DDA_SELECTF(axis1, t[1], t[2]));
+
+        active &= exit <= maxDistance;
+        distance = DDA_SELECTF(active, exit, distance);
+
+        v8i axes[3] = { axis0, axis1, axis2 };
+        v8i newFace = DDA_SELECT(axis0, (v8i){0}, DDA_SELECT(axis1, (v8i){0} + 2, (v8i){0} + 4));
+        for (int a = 0; a < 3; a++)
+        {
+            v8i across = DDA_SELECT(step[a] > 0, lo[a] + cell, lo[a] - 1);
+
+            // Clamp so rounding can't move a lane sideways out of the cell it just left
+            v8f p = o[a] + exit * d[a];
+            v8i along;
+            DDAFloor(&p, &along);
+            v8i hi = lo[a] + cell - 1;
+            along = DDA_SELECT(along < lo[a], lo[a], along);
+            along = DDA_SELECT(along > hi, hi, along);
+
+            c[a] = DDA_SELECT(active, DDA_SELECT(axes[a], across, along), c[a]);
+            newFace |= axes[a] & (step[a] > 0) & 1;
+        }
+        face = DDA_SELECT(active, newFace, face);
+    }
+
+    for (int l = 0; l < lanes; l++)
+    {
+        int i = base + l;
+        batch->hit[i] = hit[l] != 0;
+        batch->unknown[i] = unknown[l] != 0;
+        batch->voxelX[i] = c[0][l];
+        batch->voxelY[i] = c[1][l];
+        batch->voxelZ[i] = c[2][l];
+        batch->face[i] = face[l];
+        batch->distance[i] = distance[l];
+    }
+}
+
+__attribute__((target("avx2"))) static void DDA3DBatchAVX2(RayBatch *batch, int begin, int end, const World *world)
+{
+    for (int i = begin; i < end; i += DDA_LANES)
+    {
+        DDA3DPacket(batch, i, (end - i < DDA_LANES) ? end - i : DDA_LANES, world);
+    }
+}
+
+static void DDA3DBatchSSE(RayBatch *batch, int begin, int end, const World *world)
+{
+    for (int i = begin; i < end; i += DDA_LANES)
+    {
+        DDA3DPacket(batch, i, (end - i < DDA_LANES) ? end - i : DDA_LANES, world);
+    }
+}
+
+void DDA3DBatchRange(RayBatch *batch, int begin, int end, const World *world)
+{
+    if (__builtin_cpu_supports("avx2")) DDA3DBatchAVX2(batch, begin, end, world);
+    else DDA3DBatchSSE(batch, begin, end, world);
+}
+
+#else
+
+void DDA3DBatchRange(RayBatch *batch, int begin, int end, const World *world)
+{
+    for (int i = begin; i < end; i++)
+    {
+        Vector3 from = { batch->originX[i], batch->originY[i], batch->originZ[i] };
+        Vector3 dir = { batch->dirX[i], batch->dirY[i], batch->dirZ[i] };
+        RayHit result = DDA3DBrick(from, dir, batch->maxDistance[i], world);
+        batch->hit[i] = result.hit;
+        batch->unknown[i] = result.unknown;
+        batch->voxelX[i] = result.voxel.x;
+        batch->voxelY[i] = result.voxel.y;
+        batch->voxelZ[i] = result.voxel.z;
+        batch->face[i] = result.face;
+        batch->distance[i] = result.distance;
+    }
+}
+
+#endif
+
+void DDA3DBatch(RayBatch *batch, const World *world)
+{
+    DDA3DBatchRange(batch, 0, batch->count, world);
+}
+
+void TraceRayBatchTile(void *data, int begin, int end)
+{
+    RayBatchJob *job = (RayBatchJob *)data;
+    DDA3DBatchRange(job->batch, begin, end, job->world);
+}
+
+#endif // DDA_IMPLEMENTATION
@@ -1,10 +1,27 @@
+#include <string.h>
+
 #include "raylib.h"
 #include "raymath.h"
 
+#define JOBS_IMPLEMENTATION
+#include "jobs.h"
+#define HEIGHTMAP_IMPLEMENTATION
+#include "heightmap.h"
+#define HORIZONMAP_IMPLEMENTATION
+#include "horizonmap.h"
+#define LIGHTBAKE_IMPLEMENTATION
+#include "lightbake.h"
+#define PROFILER_IMPLEMENTATION
+#include "profiler.h"
+#define REPLAY_IMPLEMENTATION
+#include "replay.h"
+
 #define GLSL_VERSION 330
+#define DEFAULT_SAVE_FILE "heights.map"
 
-const int gridSize = 5;
-int grid[] = {
+// Starting layout, the HeightMap can be any size and is edited at runtime
+const int initialSize = 5;
+const int initialHeights[] = {
     1, 1, 2, 3, 1,
     1, 1, 1, 2, 1,
     1, 1, 1, 1, 1,
@@ -17,80 +34,30 @@ typedef struct Vector2i {
     int y;                // Vector y component
 } Vector2i;
 
-void DDA(Vector3 v1, Vector3 v2)
+// Trace the shadow ray from v1 to the light and draw the pyramid nodes it visits:
+// green for nodes skipped in one step, red where it had to look closer. Returns the visit count
+int DDA(Vector3 v1, Vector3 v2, const HeightMap *map)
 {
-    Vector2 rayStart = {v1.x, v1.z};
-    Vector2 rayEnd = {v2.x, v2.z};
-    Vector2 rayDir = Vector2Normalize(Vector2Subtract(rayEnd, rayStart));
-    Vector3 rayDir3 = Vector3Normalize(Vector3Subtract(v2, v1));
-    Vector2 rayUnitStepSize = { 
-        sqrt(1 + (rayDir.y * rayDir.y) / (rayDir.x * rayDir.x)), 
-        sqrt(1 + (rayDir.x * rayDir.x) / (rayDir.y * rayDir.y))
-    };
-
-    Vector2i mapCheck = {(int)rayStart.x, (int)rayStart.y};
-    Vector2 rayLength1D;
-    Vector2i step;
-
-    if (rayDir.x < 0)
-    {
-        step.x = -1;
-        rayLength1D.x = (rayStart.x - (float)mapCheck.x) * rayUnitStepSize.x;
-    }
-    else
-    {
-        step.x = 1;
-        rayLength1D.x = ((float)mapCheck.x + 1.0f - rayStart.x) * rayUnitStepSize.x;
-    }
-
-    if (rayDir.y < 0)
-    {
-        step.y = -1;
-        rayLength1D.y = (rayStart.y - (float)mapCheck.y) * rayUnitStepSize.y;
-    }
-    else
-    {
-        step.y = 1;
-        rayLength1D.y = ((float)mapCheck.y + 1.0f - rayStart.y) * rayUnitStepSize.y;
-    }
+    HeightMapNode nodes[256];
+    int nodeCount = 0;
+    TraceHeightMapShadow(map, v1, v2, nodes, 256, &nodeCount);
 
-    // Perform "Walk" until collision or range check
-    float maxDistance = 10.0f;
-    float distance = 0.0f;
-    while (distance < maxDistance)
+    Vector2 rayDir = Vector2Normalize((Vector2){ v2.x - v1.x, v2.z - v1.z });
+    for (int i = 0; i < nodeCount && i < 256; i++)
     {
-        // Walk along shortest path
-        if (rayLength1D.x < rayLength1D.y)
-        {
-            mapCheck.x += step.x;
-            distance = rayLength1D.x;
-            rayLength1D.x += rayUnitStepSize.x;
-        }
-        else
-        {
-            mapCheck.y += step.y;
-            distance = rayLength1D.y;
-            rayLength1D.y += rayUnitStepSize.y;
-        }
-
-		Vector2 intersection = Vector2Add(rayStart, Vector2Scale(rayDir, distance));
-
-        float scale = (intersection.x - v1.x) / rayDir3.x;
-        float rh = v1.y + (rayDir3.y * scale);
-        float gh = grid[mapCheck.y * gridSize + mapCheck.x]-1;
+        HeightMapNode n = nodes[i];
+        float size = (float)(1 << n.level);
+        Vector3 center = { (n.x + 0.5f) * size, n.height, (n.z + 0.5f) * size };
+        DrawCubeWires(center, size, 0.02f, size, n.skipped ? GREEN : RED);
 
-        //if (rh < gh)
-        //{
-            // move y same distance x
-            // seems fine but will only work if angle of light is 45 degrees
-            Vector3 p3 = { intersection.x, rh, intersection.y };
-            DrawSphere(p3, 0.2, (Color){255, 0, 0, 128});
-            //break;
-        //}
+        Vector3 p3 = { v1.x + rayDir.x * n.t, n.height, v1.z + rayDir.y * n.t };
+        DrawSphere(p3, 0.1f, (Color){255, 0, 0, 128});
     }
+
+    return nodeCount;
 }
 
-int DrawVoxel(Vector3 vp)
+void DrawVoxel(Vector3 vp)
 {
     Vector3 p = Vector3Add(vp, (Vector3){0.5, -0.5, 0.5});
     DrawCube(p, 1, 1, 1, BLANK);
@@ -99,7 +66,7 @@ int DrawVoxel(Vector3 vp)
 //------------------------------------------------------------------------------------
 // Program main entry point
 //------------------------------------------------------------------------------------
-int main(void)
+int main(int argc, char **argv)
 {
     // Initialization
     //--------------------------------------------------------------------------------------
@@ -110,13 +77,51 @@ int main(void)
     //Vector3 lightDir = {1, 1, -1};
     //Vector3 lightPos = Vector3Add(spherePos, Vector3Scale(lightDir, 10));
     Vector3 lightPos = {1.5, 0.5, 2.5};
+    int nodeCount = 0;
+    int sunMode = 0;                    // H toggles the directional sun, shining from spherePos towards lightPos
+    bool bakedMode = false;             // B toggles drawing the CPU baked faces instead of shading per fragment
+    bool bakeStale = false;             // Columns changed while the baked faces weren't shown
+    bool showProfiler = false;          // F1 toggles the zone timings, F2 writes them to profile.json
 
     InitWindow(screenWidth, screenHeight, "game");
+    InitJobs(0);
+    InitProfiler();
+
+    // --load file starts from a map ExportHeightMap wrote, F5 writes the current one to
+    // --save file
+    const char *loadFile = NULL;
+    const char *saveFile = DEFAULT_SAVE_FILE;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--load") == 0) loadFile = argv[i + 1];
+        else if (strcmp(argv[i], "--save") == 0) saveFile = argv[i + 1];
+    }
+
+    HeightMap map = { 0 };
+    if (loadFile != NULL) map = LoadHeightMapFile(loadFile);
+    if (map.size == 0)
+    {
+        map = LoadHeightMap(initialSize);
+        for (int z = 0; z < initialSize; z++)
+        {
+            for (int x = 0; x < initialSize; x++)
+            {
+                SetHeight(&map, x, z, initialHeights[z*initialSize + x]);
+            }
+        }
+    }
+    UploadHeightMap(&map);
+
+    HorizonMap horizon = LoadHorizonMap(&map);
+    UploadHorizonMap(&horizon);
+
+    LightBake bake = LoadLightBake(&map);
+    Material bakeMaterial = LoadMaterialDefault();
 
     // Define the camera to look into our 3d world
     Camera3D camera = { 0 };
     camera.position = (Vector3){ 10.0f, 10.0f, 10.0f }; // Camera position
-    camera.target = (Vector3){ gridSize/2, 0.0f, gridSize/2 };      // Camera looking at point
+    camera.target = (Vector3){ map.size/2, 0.0f, map.size/2 };      // Camera looking at point
     camera.up = (Vector3){ 0.0f, 1.0f, 0.0f };          // Camera up vector (rotation towards target)
     camera.fovy = 60.0f;                                // Camera field-of-view Y
     camera.projection = CAMERA_PERSPECTIVE;             // Camera projection type
@@ -125,52 +130,120 @@ int main(void)
 
     SetTargetFPS(60);                   // Set our game to run at 60 frames-per-second
 
+    // --record file logs the input of every frame, --replay file plays it back uncapped
+    // and prints the frame times at exit
+    const int replayKeys[] = { 'J', 'L', 'U', 'O', 'I', 'K', 'H', 'B', KEY_EQUAL, KEY_MINUS, KEY_F1 };
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--record") == 0) StartRecording(argv[i + 1], replayKeys, sizeof(replayKeys)/sizeof(replayKeys[0]));
+        else if (strcmp(argv[i], "--replay") == 0) StartReplay(argv[i + 1], replayKeys, sizeof(replayKeys)/sizeof(replayKeys[0]));
+    }
+
     const char* vs = TextFormat("vert.glsl", GLSL_VERSION);
     const char* fs = TextFormat("dda2.glsl", GLSL_VERSION);
     Shader shader = LoadShader(vs, fs);
 
     int loc = GetShaderLocation(shader, "lightPos");
+    int heightMapLoc = GetShaderLocation(shader, "heightMap");
+    int gridSizeLoc = GetShaderLocation(shader, "gridSize");
+    int maxMipMapLoc = GetShaderLocation(shader, "maxMipMap");
+    int horizonMapLoc = GetShaderLocation(shader, "horizonMap");
+    int sunModeLoc = GetShaderLocation(shader, "sunMode");
+    int lightDirLoc = GetShaderLocation(shader, "lightDir");
+    SetShaderValue(shader, gridSizeLoc, &map.size, SHADER_UNIFORM_INT);
+    SetShaderValue(shader, GetShaderLocation(shader, "mipLevels"), &map.mipLevels, SHADER_UNIFORM_INT);
 
     //--------------------------------------------------------------------------------------
 
     // Main game loop
-    while (!WindowShouldClose())        // Detect window close button or ESC key
+    while (!WindowShouldClose() && !IsReplayFinished())    // Detect window close button or ESC key, or the end of a replay
     {
+        BeginProfileFrame();
+
         // Update
         //----------------------------------------------------------------------------------
-        UpdateCamera(&camera, CAMERA_THIRD_PERSON);
-
-        if (IsKeyDown('J')) lightPos.x -= 0.25f;
-        if (IsKeyDown('L')) lightPos.x += 0.25f;
-        if (IsKeyDown('U')) lightPos.y += 0.25f;
-        if (IsKeyDown('O')) lightPos.y -= 0.25f;
-        if (IsKeyDown('I')) lightPos.z -= 0.25f;
-        if (IsKeyDown('K')) lightPos.z += 0.25f;
+        BeginProfileZone("update");
+        if (!IsReplaying()) UpdateCamera(&camera, CAMERA_THIRD_PERSON);
+        ReplayFrame(&camera);
+
+        if (IsReplayKeyDown('J')) lightPos.x -= 0.25f;
+        if (IsReplayKeyDown('L')) lightPos.x += 0.25f;
+        if (IsReplayKeyDown('U')) lightPos.y += 0.25f;
+        if (IsReplayKeyDown('O')) lightPos.y -= 0.25f;
+        if (IsReplayKeyDown('I')) lightPos.z -= 0.25f;
+        if (IsReplayKeyDown('K')) lightPos.z += 0.25f;
+        if (IsReplayKeyPressed('H')) sunMode = !sunMode;
+        if (IsReplayKeyPressed('B')) bakedMode = !bakedMode;
+        if (IsReplayKeyPressed(KEY_F1)) showProfiler = !showProfiler;
+        if (IsKeyPressed(KEY_F2) && ExportProfileTrace("profile.json")) TraceLog(LOG_INFO, "PROFILER: Trace saved to profile.json");
+        if (IsKeyPressed(KEY_F5) && ExportHeightMap(&map, saveFile)) TraceLog(LOG_INFO, "HEIGHTMAP: [%s] Height map saved", saveFile);
+        Vector3 lightDir = Vector3Normalize(Vector3Subtract(lightPos, spherePos));
+
+        // Raise or lower the column under the light
+        int lightX = (int)floorf(lightPos.x);
+        int lightZ = (int)floorf(lightPos.z);
+        int lightHeight = GetHeight(&map, lightX, lightZ);
+        if (IsReplayKeyPressed(KEY_EQUAL)) SetHeight(&map, lightX, lightZ, lightHeight + 1);
+        if (IsReplayKeyPressed(KEY_MINUS) && lightHeight > 0) SetHeight(&map, lightX, lightZ, lightHeight - 1);
+        if (GetHeight(&map, lightX, lightZ) != lightHeight)
+        {
+            UpdateHorizonMap(&horizon, &map, lightX, lightZ);
+
+            // The baked faces are only kept up to date while they are drawn
+            if (bakedMode) UpdateLightBakeColumn(&bake, &map, lightX, lightZ);
+            else bakeStale = true;
+        }
+        UploadHeightMap(&map);
+        UploadHorizonMap(&horizon);
+
+        if (bakedMode && bakeStale)
+        {
+            UpdateLightBakeGeometry(&bake, &map);
+            bakeStale = false;
+        }
+
+        // Costs nothing while neither the light nor the columns changed
+        bool rebaked = bakedMode && BakeLight(&bake, &map, sunMode ? lightDir : lightPos, sunMode);
+        EndProfileZone();
         //----------------------------------------------------------------------------------
 
         // Draw
         //----------------------------------------------------------------------------------
         BeginDrawing();
+        BeginProfileZone("draw");
 
             ClearBackground(RAYWHITE);
 
+            BeginProfileGpuZone("scene");
             BeginMode3D(camera);
 
-                BeginShaderMode(shader);
-                SetShaderValue(shader, loc, &lightPos, SHADER_UNIFORM_VEC3);
-
-                for (int z=0; z<gridSize; z++)
+                if (bakedMode)
+                {
+                    DrawLightBake(&bake, bakeMaterial);
+                }
+                else
                 {
-                    for (int x=0; x<gridSize; x++)
+                    BeginShaderMode(shader);
+                    SetShaderValue(shader, loc, &lightPos, SHADER_UNIFORM_VEC3);
+                    SetShaderValueTexture(shader, heightMapLoc, map.texture);
+                    if (map.mipLevels > 0) SetShaderValueTexture(shader, maxMipMapLoc, map.mipTexture);
+                    SetShaderValue(shader, sunModeLoc, &sunMode, SHADER_UNIFORM_INT);
+                    SetShaderValue(shader, lightDirLoc, &lightDir, SHADER_UNIFORM_VEC3);
+                    SetShaderValueTexture(shader, horizonMapLoc, horizon.texture);
+
+                    for (int z=0; z<map.size; z++)
                     {
-                        int h = grid[z * gridSize + x];
-                        for (int y=0; y<h; y++)
+                        for (int x=0; x<map.size; x++)
                         {
-                            DrawVoxel((Vector3){x, y, z});
+                            int h = GetHeight(&map, x, z);
+                            for (int y=0; y<h; y++)
+                            {
+                                DrawVoxel((Vector3){x, y, z});
+                            }
                         }
                     }
+                    EndShaderMode();
                 }
-                EndShaderMode();
 
                 DrawRay((Ray){{0, 0, 0}, {1, 0, 0}}, (Color){ 255, 0, 0, 255 });
                 DrawRay((Ray){{0, 0, 0}, {0, 1, 0}}, (Color){ 0, 255, 0, 255 });
@@ -182,20 +255,40 @@ int main(void)
                 //DrawRay((Ray){spherePos, lightDir}, BLACK);
                 DrawRay((Ray){spherePos, Vector3Normalize(Vector3Subtract(lightPos, spherePos))}, BLACK);
 
-                DDA(spherePos, lightPos);
+                BeginProfileZone("dda");
+                nodeCount = DDA(spherePos, lightPos, &map);
+                EndProfileZone();
 
             EndMode3D();
+            EndProfileGpuZone();
 
             DrawFPS(10, 10);
             DrawText(TextFormat("(%.02f, %.02f, %.02f) -> (%.02f, %.02f, %.02f)", spherePos.x, spherePos.y, spherePos.z, lightPos.x, lightPos.y, lightPos.z), 20, 40, 20, BLACK);
-            //DrawText(TextFormat("(%.02f, %.02f)", i.x, i.y), 20, 80, 20, BLACK);
+            DrawText(TextFormat("%d nodes visited", nodeCount), 20, 80, 20, BLACK);
+            DrawText(sunMode ? "sun (horizon map), H for point light" : "point light (max-mip trace), H for sun", 20, 120, 20, BLACK);
+            if (bakedMode) DrawText(TextFormat("baked, %d faces%s, B for per fragment", bake.faceCount, rebaked ? ", rebaked" : ""), 20, 160, 20, BLACK);
+            if (showProfiler) DrawProfiler(screenWidth - 430, 10);
 
+        EndProfileZone();
+        BeginProfileZone("present");
         EndDrawing();
+        EndProfileZone();
         //----------------------------------------------------------------------------------
+
+        EndProfileFrame();
     }
 
     // De-Initialization
     //--------------------------------------------------------------------------------------
+    UnloadReplay();                     // First, so teardown does not count as replay time
+    UnloadShader(shader);
+    UnloadLightBake(&bake);
+    UnloadMaterial(bakeMaterial);
+    UnloadHorizonMap(&horizon);
+    UnloadHeightMap(&map);
+    UnloadJobs();
+    UnloadProfiler();
+
     CloseWindow();        // Close window and OpenGL context
     //--------------------------------------------------------------------------------------
 
@@ -6,91 +6,137 @@ in vec4 worldPosition;
 
 out vec4 fragColor;
 
-const vec3 lightDir = vec3(1, 1, -1);
+const int horizonDirections = 16;  // HORIZON_DIRECTIONS in horizonmap.h
 
-const int gridSize = 5;
-int grid[] = {
-    1, 1, 2, 3, 1,
-    1, 1, 1, 2, 1,
-    1, 1, 1, 1, 1,
-    1, 1, 1, 1, 1,
-    1, 1, 1, 1, 1,
-};
+uniform int gridSize;           // Cells per side of heightMap
+uniform sampler2D heightMap;    // Column heights, texel (x, z) is column x of row z
+uniform int mipLevels;          // Levels of maxMipMap above heightMap
+uniform sampler2D maxMipMap;    // Max height pyramid atlas
 
 uniform vec3 lightPos;
+uniform int sunMode;            // 1: directional light along lightDir tested on horizonMap, 0: point light at lightPos
+uniform vec3 lightDir;          // Towards the sun
+uniform sampler2D horizonMap;   // Horizon tangents, 4 azimuths per RGBA texel (layout in horizonmap.h)
 
+// Column height at cell, 0 outside the map
+int gridHeight(ivec2 cell)
+{
+    if (any(lessThan(cell, ivec2(0))) || any(greaterThanEqual(cell, ivec2(gridSize)))) return 0;
+    return int(texelFetch(heightMap, cell, 0).r);
+}
+
+// Tallest column under node of a max-mip level, 0 outside (layout in heightmap.h)
+int maxHeight(int level, ivec2 node)
+{
+    if (level == 0) return gridHeight(node);
+
+    int p = 1 << mipLevels;
+    if (any(lessThan(node, ivec2(0))) || any(greaterThanEqual(node, ivec2(p >> level)))) return 0;
+    return int(texelFetch(maxMipMap, node + ivec2(0, p - (p >> (level - 1))), 0).r);
+}
+
+// Walk the max-mip pyramid towards the light, same traversal as TraceHeightMapShadow
 bool inShadow(vec3 v1)
 {
     vec3 v2 = lightPos; //v1.xyz + lightDir * 10;
     vec2 rayStart = v1.xz;
-    vec2 rayEnd = v2.xz;
-    vec2 rayDir = normalize(rayEnd - rayStart);
-    vec3 rayDir3 = normalize(v2 - v1);
-    vec2 rayUnitStepSize = { sqrt(1 + (rayDir.y / rayDir.x) * (rayDir.y / rayDir.x)), sqrt(1 + (rayDir.x / rayDir.y) * (rayDir.x / rayDir.y)) };
-    vec2 rayLength1D;
-
-    ivec2 mapCheck = ivec2(int(rayStart.x), int(rayStart.y));
-    ivec2 step = ivec2(0, 0);
-
-    if (rayDir.x < 0)
-    {
-        step.x = -1;
-        rayLength1D.x = (rayStart.x - float(mapCheck.x)) * rayUnitStepSize.x;
-    }
-    else
+    vec2 delta = v2.xz - rayStart;
+    float tMax = length(delta);
+    if (tMax < 1e-6) return false;
+
+    // t is horizontal distance from v1, the ray climbs slope per unit of t
+    vec2 rayDir = delta / tMax;
+    float slope = (v2.y - v1.y) / tMax;
+    ivec2 step = ivec2(rayDir.x < 0 ? -1 : 1, rayDir.y < 0 ? -1 : 1);
+    vec2 stepUp = vec2(greaterThan(step, ivec2(0)));
+    vec2 invDir = vec2(step) / max(abs(rayDir), vec2(1e-20));
+    int p = 1 << mipLevels;
+
+    // Leave the fragment's own column first
+    ivec2 node = ivec2(floor(rayStart));
+    vec2 tAxis = (vec2(node) + stepUp - rayStart) * invDir;
+    float t = min(tAxis.x, tAxis.y);
+    if (tAxis.x < tAxis.y) node.x += step.x; else node.y += step.y;
+    int level = 0;
+
+    while (t < tMax)
     {
-        step.x = 1;
-        rayLength1D.x = (float(mapCheck.x) + 1.0f - rayStart.x) * rayUnitStepSize.x;
-    }
+        // Walking away from the map, nothing left to hit
+        int side = p >> level;
+        if ((node.x < 0 && step.x < 0) || (node.y < 0 && step.y < 0) ||
+            (node.x >= side && step.x > 0) || (node.y >= side && step.y > 0))
+        {
+            break;
+        }
 
-    if (rayDir.y < 0)
-    {
-        step.y = -1;
-        rayLength1D.y = (rayStart.y - float(mapCheck.y)) * rayUnitStepSize.y;
-    }
-    else
-    {
-        step.y = 1;
-        rayLength1D.y = (float(mapCheck.y) + 1.0f - rayStart.y) * rayUnitStepSize.y;
-    }
+        float size = float(1 << level);
+        tAxis = ((vec2(node) + stepUp) * size - rayStart) * invDir;
+        float tExit = min(tAxis.x, tAxis.y);
 
-    // Perform "Walk" until collision or range check
-    float maxDistance = 10.0f;
-    float distance = 0.0f;
-    while (distance < maxDistance)
-    {
-        // Walk along shortest path
-        if (rayLength1D.x < rayLength1D.y)
+        // Lowest point of the ray over the node
+        float rayMin = v1.y + slope * (slope >= 0 ? t : min(tExit, tMax));
+
+        if (rayMin >= float(maxHeight(level, node) - 1))
         {
-            mapCheck.x += step.x;
-            distance = rayLength1D.x;
-            rayLength1D.x += rayUnitStepSize.x;
+            // Skip the whole node, going up a level when entering a new parent
+            ivec2 next = node;
+            if (tAxis.x < tAxis.y) next.x += step.x; else next.y += step.y;
+            t = max(t, tExit);
+            if (level < mipLevels && any(notEqual(next >> 1, node >> 1)))
+            {
+                level++;
+                next >>= 1;
+            }
+            node = next;
+        }
+        else if (level == 0)
+        {
+            return true;
         }
         else
         {
-            mapCheck.y += step.y;
-            distance = rayLength1D.y;
-            rayLength1D.y += rayUnitStepSize.y;
+            // Descend into the child the ray is in at t
+            level--;
+            size *= 0.5;
+            ivec2 child = clamp(ivec2(floor((rayStart + rayDir * t) / size)), node * 2, node * 2 + 1);
+            for (int i = 0; i < 2; i++)
+            {
+                tAxis = ((vec2(child) + stepUp) * size - rayStart) * invDir;
+                if (tAxis.x <= t && tAxis.x <= tAxis.y && ((child.x + step.x) >> 1) == node.x) child.x += step.x;
+                else if (tAxis.y <= t && ((child.y + step.y) >> 1) == node.y) child.y += step.y;
+            }
+            node = child;
         }
+    }
 
-        vec2 intersection = rayStart + rayDir * distance;
+    return false;
+}
 
-        int i = (gridSize * int(mapCheck.y)) + int(mapCheck.x);
-        int gh = 0;
-        if (i >= 0 && i < (gridSize * gridSize)) {
-            gh = grid[i]-1;
-        }
+// Stored horizon tangent of cell towards azimuth k
+float horizonSample(ivec2 cell, int k)
+{
+    return texelFetch(horizonMap, ivec2(cell.x*(horizonDirections/4) + k/4, cell.y), 0)[k & 3];
+}
 
-        float scale = (intersection.x - v1.x) / rayDir3.x;
-        float rh = v1.y + (rayDir3.y * scale);
+// Sun shadow as a lookup: the sun is hidden when it is not above the horizon of the cell,
+// blended between the two stored azimuths around it
+bool inSunShadow(vec3 p, vec3 normal)
+{
+    if (dot(normal, lightDir) <= 0 || lightDir.y <= 0) return true;
 
-        if (rh < float(gh))
-        {
-            return true;
-        }
-    }
+    float horizontal = length(lightDir.xz);
+    if (horizontal < 1e-6) return false;
 
-    return false;
+    // Side faces belong to the column behind them
+    ivec2 cell = ivec2(floor(p.xz - normal.xz*0.5));
+    if (any(lessThan(cell, ivec2(0))) || any(greaterThanEqual(cell, ivec2(gridSize)))) return false;
+
+    float k = atan(lightDir.z, lightDir.x)/(2.0*3.14159265)*horizonDirections;
+    k = mod(k, float(horizonDirections));
+    int k0 = int(k) % horizonDirections;
+    float horizon = mix(horizonSample(cell, k0), horizonSample(cell, (k0 + 1) % horizonDirections), fract(k));
+
+    return lightDir.y/horizontal <= horizon;
 }
 
 vec4 colorGradient(vec3 p) {
@@ -102,11 +148,7 @@ vec4 colorFlat(vec3 p) {
 }
 
 vec4 colorGridHeight(vec3 p) {
-    int i = (gridSize * int(p.z)) + int(p.x);
-    int h = 0;
-    if (i >= 0 && i < (gridSize * gridSize)) {
-        h = grid[i];
-    }
+    int h = gridHeight(ivec2(int(p.x), int(p.z)));
     return vec4(vec3(h, 0, 0)/gridSize, 1.0);
 }
 
@@ -114,9 +156,13 @@ void main()
 {
     //fragColor = colorFlat(modelPosition.xyz);
 
+    // Faces are flat, the screen space derivatives give the normal facing the camera
+    vec3 normal = normalize(cross(dFdx(modelPosition.xyz), dFdy(modelPosition.xyz)));
+    bool shadowed = (sunMode == 1) ? inSunShadow(modelPosition.xyz, normal) : inShadow(modelPosition.xyz);
+
     if (modelPosition.y < 0) {
         fragColor = vec4(0, 0, 0, 1);
-    } else if (inShadow(modelPosition.xyz)) {
+    } else if (shadowed) {
         fragColor = vec4(0, 0.25, 0, 1);
     } else {
         fragColor = vec4(0, 1, 0, 1);
@@ -1,48 +1,44 @@
+#include <stdlib.h>
+#include <string.h>
+
 #include "raylib.h"
 #include "raymath.h"
 
-#define GLSL_VERSION 330
+#define WORLD_IMPLEMENTATION
+#include "world.h"
 
-const int worldSize = 10;
-const int worldSizeSquared = worldSize * worldSize;
-const int worldSizeCubed = worldSize * worldSize * worldSize;
+#define DDA_IMPLEMENTATION
+#include "dda.h"
 
-typedef struct Vector2i {
-    int x;                // Vector x component
-    int y;                // Vector y component
-} Vector2i;
+#define JOBS_IMPLEMENTATION
+#include "jobs.h"
+#define PROFILER_IMPLEMENTATION
+#include "profiler.h"
+#define REPLAY_IMPLEMENTATION
+#include "replay.h"
+#define CULL_IMPLEMENTATION
+#include "cull.h"
+#define STREAM_IMPLEMENTATION
+#include "stream.h"
 
-typedef struct Vector3i {
-    int x;                // Vector x component
-    int y;                // Vector y component
-    int z;                // Vector y component
-} Vector3i;
+#define GLSL_VERSION 330
 
-Vector3 intersections[30];
-Vector3i intersections2[30];
+#define QUERY_RAYS 4096
+#define QUERY_TILE_SIZE 256
+#define MAX_INTERSECTIONS 30
+#define DEFAULT_WORLD_SIZE 10
+#define DEFAULT_STREAM_BUDGET 256       // MB
+#define DEFAULT_STREAM_RADIUS 6         // Chunks
+#define DEFAULT_SAVE_FILE "world.strm"
 
-int WorldIndex(Vector3i p)
-{
-    return p.z * worldSizeSquared +
-           p.y * worldSize +
-           p.x;
-}
+Vector3 intersections[MAX_INTERSECTIONS];
+Vector3i intersections2[MAX_INTERSECTIONS];
 
-void SetWorld(Vector3i p, int v, int* world)
-{
-    int i = WorldIndex(p);
-    if (i >= 0 && i < worldSizeCubed) {
-        world[i] = v;
-    }
-}
-
-void DrawVoxel(Vector3i p, int* world)
+void DrawVoxel(Vector3i p, World* world)
 {
     Vector3 cp = Vector3Add((Vector3){p.x, p.y, p.z}, (Vector3){0.5, 0.5, 0.5});
 
-    int i = WorldIndex(p);
-
-    if (i >= 0 && i < worldSizeCubed && world[i])
+    if (GetWorld(p, world))
     {
         DrawCube(cp, 1, 1, 1, (Color){255, 0, 0, 64});
     }
@@ -52,202 +48,53 @@ void DrawVoxel(Vector3i p, int* world)
     }
 }
 
-void DDAX(Vector3 start, Vector3 end, int* world)
+// Debug views of the dda.h walks: the walk fills intersections, this draws them
+
+void DDAX(Vector3 start, Vector3 end, World* world)
 {
     Vector3 dir = Vector3Normalize(Vector3Subtract(end, start));
-    Vector3 pos = start;
-
-    int i = 0;
-    while(pos.x < 9 && pos.y < 9 && pos.z < 9) {
-        // how far do we have to travel along dir until we get to next xyz grid position
-        float distX = ((int)pos.x + 1 - pos.x) / dir.x;
-        float distY = ((int)pos.y + 1 - pos.y) / dir.y;
-        float distZ = ((int)pos.z + 1 - pos.z) / dir.z;
-
-        // travel along the shortest distance
-        if(distX <= distY && distX <= distZ) {
-            pos = Vector3Add(pos, Vector3Scale(dir, distX));
-        } else if(distY <= distX && distY <= distZ) {
-            pos = Vector3Add(pos, Vector3Scale(dir, distY));
-        } else {
-            pos = Vector3Add(pos, Vector3Scale(dir, distZ));
-        }
+    int count = DDAXWalk(start, dir, world->size - 1, MAX_INTERSECTIONS, intersections, intersections2);
 
-        Vector3i worldPos = {(int)pos.x, (int)pos.y, (int)pos.z};
-        SetWorld(worldPos, 1, world);
-        DrawSphere(pos, 0.2, (Color){255, 0, 0, 128});
-        intersections2[i] = worldPos;
-        intersections[i++] = pos;
+    for (int i = 0; i < count; i++)
+    {
+        SetWorld(intersections2[i], 1, world);
+        DrawSphere(intersections[i], 0.2, (Color){255, 0, 0, 128});
     }
 }
 
-void DDA2D(Vector3 v1, Vector3 v2, int* world)
+void DDA2D(Vector3 v1, Vector3 v2, World* world)
 {
     Vector2 rayStart = {v1.x, v1.z};
-    Vector2 rayEnd = {v2.x, v2.z};
-    Vector2 rayDir = Vector2Normalize(Vector2Subtract(rayEnd, rayStart));
-    Vector2 rayUnitStepSize = { 
-        sqrt(1 + (rayDir.y * rayDir.y) / (rayDir.x * rayDir.x)), 
-        sqrt(1 + (rayDir.x * rayDir.x) / (rayDir.y * rayDir.y))
-    };
-
-    Vector2i mapCheck = {(int)rayStart.x, (int)rayStart.y};
-    Vector2 rayLength1D;
-    Vector2i step;
-
-    if (rayDir.x < 0)
-    {
-        step.x = -1;
-        rayLength1D.x = (rayStart.x - (float)mapCheck.x) * rayUnitStepSize.x;
-    }
-    else
-    {
-        step.x = 1;
-        rayLength1D.x = ((float)mapCheck.x + 1.0f - rayStart.x) * rayUnitStepSize.x;
-    }
+    Vector2 rayDir = Vector2Normalize(Vector2Subtract((Vector2){v2.x, v2.z}, rayStart));
 
-    if (rayDir.y < 0)
-    {
-        step.y = -1;
-        rayLength1D.y = (rayStart.y - (float)mapCheck.y) * rayUnitStepSize.y;
-    }
-    else
-    {
-        step.y = 1;
-        rayLength1D.y = ((float)mapCheck.y + 1.0f - rayStart.y) * rayUnitStepSize.y;
-    }
+    Vector2 points[MAX_INTERSECTIONS];
+    int count = DDA2DWalk(rayStart, rayDir, 10.0f, points, MAX_INTERSECTIONS);
+    if (count > MAX_INTERSECTIONS) count = MAX_INTERSECTIONS;
 
-    // Perform "Walk" until collision or range check
-    float maxDistance = 10.0f;
-    float distance = 0.0f;
-    int i = 0;
-    while (distance < maxDistance-1)
+    for (int i = 0; i < count; i++)
     {
-        // Walk along shortest path
-        if (rayLength1D.x < rayLength1D.y)
-        {
-            mapCheck.x += step.x;
-            distance = rayLength1D.x;
-            rayLength1D.x += rayUnitStepSize.x;
-        }
-        else
-        {
-            mapCheck.y += step.y;
-            distance = rayLength1D.y;
-            rayLength1D.y += rayUnitStepSize.y;
-        }
-
-		Vector2 intersection = Vector2Add(rayStart, Vector2Scale(rayDir, distance));
-        Vector3 p3 = { intersection.x, 0.5, intersection.y };
-        intersections[i++] = p3;
+        Vector3 p3 = { points[i].x, 0.5, points[i].y };
+        intersections[i] = p3;
         DrawSphere(p3, 0.2, (Color){255, 0, 0, 128});
     }
 }
 
-void DDA3D(Vector3 from, Vector3 to, int* world)
+void DDA3D(Vector3 from, Vector3 to, World* world)
 {
     Vector3 rayDir = Vector3Normalize(Vector3Subtract(to, from));
+    int count = DDA3DWalk(from, rayDir, world->size * 1.75f, intersections, intersections2, MAX_INTERSECTIONS);
+    if (count > MAX_INTERSECTIONS) count = MAX_INTERSECTIONS;
 
-    // distance the ray has to travel to go from 1 xyz side to the next
-    Vector3 rayUnitStepSize = {
-        sqrt(1 + (rayDir.z * rayDir.z) / (rayDir.x * rayDir.x)), 
-        sqrt(1 + (rayDir.x * rayDir.x) / (rayDir.y * rayDir.y)),
-        sqrt(1 + (rayDir.y / rayDir.y) / (rayDir.z / rayDir.z))
-    };
-
-    Vector3i mapCheck = { (int)from.x, (int)from.y, (int)from.z };
-    Vector3i step;
-    Vector3 rayLength1D = {0, 0, 0};
-
-    if (rayDir.x < 0)
-    {
-        step.x = -1;
-        rayLength1D.x = (from.x - (float)mapCheck.x) * rayUnitStepSize.x;
-    }
-    else
-    {
-        step.x = 1;
-        rayLength1D.x = ((float)mapCheck.x + 1.0f - from.x) * rayUnitStepSize.x;
-    }
-
-    if (rayDir.y < 0)
-    {
-        step.y = -1;
-        rayLength1D.y = (from.y - (float)mapCheck.y) * rayUnitStepSize.y;
-    }
-    else
-    {
-        step.y = 1;
-        rayLength1D.y = ((float)mapCheck.y + 1.0f - from.y) * rayUnitStepSize.y;
-    }
-
-    if (rayDir.z < 0)
+    for (int i = 0; i < count; i++)
     {
-        step.z = -1;
-        rayLength1D.z = (from.z - (float)mapCheck.z) * rayUnitStepSize.z;
+        DrawSphere(intersections[i], 0.2, (Color){255, 255, 0, 255});
     }
-    else
-    {
-        step.z = 1;
-        rayLength1D.z = ((float)mapCheck.z + 1.0f - from.z) * rayUnitStepSize.z;
-    }
-
-    // Perform "Walk" until collision or range check
-    float maxDistance = worldSize - 1.5;
-    float distance = 0.0f;
-    //while (distance < maxDistance)
-
-    while (true)
-    {
-        bool walkedX = false;
-        bool walkedY = false;
-        bool walkedZ = false;
-
-        // Walk along shortest path
-        if (rayLength1D.x < rayLength1D.y && rayLength1D.x < rayLength1D.z)
-        {
-            mapCheck.x += step.x;
-            distance = rayLength1D.x;
-            rayLength1D.x += rayUnitStepSize.x;
-            walkedX = true;
-        }
-        else
-        if (rayLength1D.y < rayLength1D.x && rayLength1D.y < rayLength1D.z)
-        {
-            mapCheck.y += step.y;
-            distance = rayLength1D.y;
-            rayLength1D.y += rayUnitStepSize.y;
-            walkedY = true;
-        }
-        else
-        //if (rayLength1D.z < rayLength1D.x && rayLength1D.z < rayLength1D.y)
-        {
-            mapCheck.z += step.z;
-            distance = rayLength1D.z;
-            rayLength1D.z += rayUnitStepSize.z;
-            walkedZ = true;
-        }
-
-		Vector3 intersection = Vector3Add(from, Vector3Scale(rayDir, distance));
-        //SetWorld((Vector3i){(int)intersection.x, (int)intersection.y, (int)intersection.z}, 1, world);
-        //SetWorld(mapCheck, 1, world);
-        DrawSphere(intersection, 0.2, (Color){255, 255, 0, 255});
-
-        if (mapCheck.x > worldSize ||
-            mapCheck.y > worldSize ||
-            mapCheck.z > worldSize) {
-            step.x = 0;
-            break;
-        }
-    }
-
-    step.x = 0;
 }
 
 //------------------------------------------------------------------------------------
 // Program main entry point
 //------------------------------------------------------------------------------------
-int main(void)
+int main(int argc, char **argv)
 {
     // Initialization
     //--------------------------------------------------------------------------------------
@@ -255,19 +102,39 @@ int main(void)
     const int screenHeight = 900;
 
     Vector3 startPos = {0.5, 0.5, 0.5};
-    Vector3 endPos = {7.5, 5.5, 5.5}; //{worldSize - 0.5, worldSize - 0.5, worldSize - 0.5};
+    Vector3 endPos = {7.5, 5.5, 5.5};
+
+    // --size n sets the voxels per world side, up to WORLD_MAX_SIZE. --stream file streams
+    // the world from a world file instead (bench --export-world writes one), keeping
+    // --budget MB of chunks within --radius chunks of the camera. --load file reads all of
+    // it up front. F5 saves a snapshot to --save file in the background
+    int worldSize = DEFAULT_WORLD_SIZE;
+    const char *streamFile = NULL;
+    const char *loadFile = NULL;
+    const char *saveFile = DEFAULT_SAVE_FILE;
+    int streamBudget = DEFAULT_STREAM_BUDGET;
+    int streamRadius = DEFAULT_STREAM_RADIUS;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--size") == 0) worldSize = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--stream") == 0) streamFile = argv[i + 1];
+        else if (strcmp(argv[i], "--budget") == 0) streamBudget = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--radius") == 0) streamRadius = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--load") == 0) loadFile = argv[i + 1];
+        else if (strcmp(argv[i], "--save") == 0) saveFile = argv[i + 1];
+    }
 
-    int world[worldSizeCubed];
-    //world[0] = 1;
-    //world[worldSizeSquared] = 1;
-    //world[worldSizeCubed-1] = 1;
+    World world = {0};
+    bool streaming = (streamFile != NULL) && LoadWorldStream(&world, streamFile, (size_t)streamBudget << 20, streamRadius);
+    bool loaded = !streaming && (loadFile != NULL) && LoadWorldFile(&world, loadFile);
+    if (!streaming && !loaded) InitWorld(&world, worldSize);
 
     InitWindow(screenWidth, screenHeight, "game");
 
     // Define the camera to look into our 3d world
     Camera3D camera = { 0 };
     camera.position = (Vector3){ 10.0f, 10.0f, 10.0f }; // Camera position
-    camera.target = (Vector3){ worldSize/2, 0.0f, worldSize/2 };      // Camera looking at point
+    camera.target = (Vector3){ world.size/2, 0.0f, world.size/2 };    // Camera looking at point
     camera.up = (Vector3){ 0.0f, 1.0f, 0.0f };          // Camera up vector (rotation towards target)
     camera.fovy = 60.0f;                                // Camera field-of-view Y
     camera.projection = CAMERA_PERSPECTIVE;             // Camera projection type
@@ -275,50 +142,164 @@ int main(void)
     DisableCursor();                    // Limit cursor to relative movement inside the window
     SetTargetFPS(60);                   // Set our game to run at 60 frames-per-second
 
+    // --record file logs the input of every frame, --replay file plays it back uncapped
+    // and prints the frame times at exit
+    const int replayKeys[] = { 'J', 'L', 'U', 'O', 'I', 'K', KEY_F1 };
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--record") == 0) StartRecording(argv[i + 1], replayKeys, sizeof(replayKeys)/sizeof(replayKeys[0]));
+        else if (strcmp(argv[i], "--replay") == 0) StartReplay(argv[i + 1], replayKeys, sizeof(replayKeys)/sizeof(replayKeys[0]));
+    }
+
     //--------------------------------------------------------------------------------------
 
+    RayHit flatHit = {0};
+    RayHit brickHit = {0};
+
+    // Visibility queries in every direction from startPos, traced on the job threads
+    // against a snapshot of the world and picked up at the start of the next frame.
+    // Each frame only recopies the chunks that changed into the snapshot
+    InitJobs(0);
+    InitProfiler();
+    bool showProfiler = false;          // F1 toggles the zone timings, F2 writes them to profile.json
+    World snapshot = {0};
+    RayBatch queries = LoadRayBatch(QUERY_RAYS);
+    for (int i = 0; i < QUERY_RAYS; i++)
+    {
+        float y = 1 - 2 * (i + 0.5f) / QUERY_RAYS;
+        float r = sqrtf(1 - y*y);
+        float a = i * 2.39996323f;
+        SetBatchRay(&queries, i, startPos, (Vector3){ r*cosf(a), y, r*sinf(a) }, world.size * 2.0f);
+    }
+    ChunkVisibility visibility = LoadChunkVisibility(&world);
+    RayBatchJob queryJob = { &queries, &snapshot };
+    JobGroup queryGroup = {0};
+    bool queryInFlight = false;
+    int queryHits = 0;
+    int queryUnknown = 0;               // Stopped at chunks not streamed in yet
+
     // Main game loop
-    while (!WindowShouldClose())        // Detect window close button or ESC key
+    while (!WindowShouldClose() && !IsReplayFinished())    // Detect window close button or ESC key, or the end of a replay
     {
-        for(int i = 0; i < worldSizeCubed; i++) {
-            world[i] = 0;
+        BeginProfileFrame();
+
+        if (queryInFlight)
+        {
+            BeginProfileZone("queries");
+            WaitJobGroup(&queryGroup);  // Normally finished during the previous frame
+            EndProfileZone();
+            queryInFlight = false;
+            queryHits = 0;
+            queryUnknown = 0;
+            for (int i = 0; i < QUERY_RAYS; i++)
+            {
+                queryHits += queries.hit[i];
+                queryUnknown += queries.unknown[i];
+            }
         }
 
-        for(int i=0; i<30; i++) {
+        // The debug walks draw into the world, a streamed or loaded one is left alone
+        if (!streaming && !loaded) ClearWorld(&world, 0);
+
+        for(int i=0; i<MAX_INTERSECTIONS; i++) {
             intersections[i] = (Vector3){0, 0, 0};
             intersections2[i] = (Vector3i){0, 0, 0};
         }
 
         // Update
         //----------------------------------------------------------------------------------
-        UpdateCamera(&camera, CAMERA_THIRD_PERSON);
-
-        if (IsKeyPressed('J')) endPos.x -= 1;
-        if (IsKeyPressed('L')) endPos.x += 1;
-        if (IsKeyPressed('U')) endPos.y += 1;
-        if (IsKeyPressed('O')) endPos.y -= 1;
-        if (IsKeyPressed('I')) endPos.z -= 1;
-        if (IsKeyPressed('K')) endPos.z += 1;
+        BeginProfileZone("update");
+        if (!IsReplaying()) UpdateCamera(&camera, CAMERA_THIRD_PERSON);
+        ReplayFrame(&camera);
+
+        if (IsReplayKeyPressed('J')) endPos.x -= 1;
+        if (IsReplayKeyPressed('L')) endPos.x += 1;
+        if (IsReplayKeyPressed('U')) endPos.y += 1;
+        if (IsReplayKeyPressed('O')) endPos.y -= 1;
+        if (IsReplayKeyPressed('I')) endPos.z -= 1;
+        if (IsReplayKeyPressed('K')) endPos.z += 1;
+        if (IsReplayKeyPressed(KEY_F1)) showProfiler = !showProfiler;
+        if (IsKeyPressed(KEY_F2) && ExportProfileTrace("profile.json")) TraceLog(LOG_INFO, "PROFILER: Trace saved to profile.json");
+        if (IsKeyPressed(KEY_F5))
+        {
+            // Only the copy of the dirty chunks lands in this frame
+            BeginProfileZone("snapshot");
+            SaveWorldSnapshot(&world, saveFile);
+            EndProfileZone();
+        }
+        EndProfileZone();
+
+        if (streaming)
+        {
+            BeginProfileZone("stream");
+            UpdateWorldStream(&world, camera);
+            EndProfileZone();
+
+            WorldStreamStats stats = GetWorldStreamStats();
+            SetProfileCounter("stream resident", stats.resident);
+            SetProfileCounter("stream pending", stats.pending);
+            SetProfileCounter("stream MB", stats.residentBytes/1048576.0);
+            SetProfileCounter("stream hit %", 100.0*stats.hits/((stats.hits + stats.misses) ? stats.hits + stats.misses : 1));
+            SetProfileCounter("stream evictions", (double)stats.evictions);
+        }
         //----------------------------------------------------------------------------------
 
         // Draw
         //----------------------------------------------------------------------------------
         BeginDrawing();
+        BeginProfileZone("draw");
 
             ClearBackground(RAYWHITE);
 
+            BeginProfileGpuZone("scene");
             BeginMode3D(camera);
 
-                DDAX(startPos, endPos, world);
-                //DDA2D(startPos, endPos, world);
+                BeginProfileZone("dda");
+                if (!streaming && !loaded) DDAX(startPos, endPos, &world);
+                //DDA2D(startPos, endPos, &world);
 
-                for (int z=0; z<worldSize; z++)
+                Vector3 rayDir = Vector3Normalize(Vector3Subtract(endPos, startPos));
+                float rayLength = Vector3Distance(startPos, endPos);
+                flatHit = DDA3DFlat(startPos, rayDir, rayLength, &world);
+                brickHit = DDA3DBrick(startPos, rayDir, rayLength, &world);
+                if (brickHit.hit)
                 {
-                    for (int y=0; y<worldSize; y++)
+                    Vector3 hp = { brickHit.voxel.x + 0.5f, brickHit.voxel.y + 0.5f, brickHit.voxel.z + 0.5f };
+                    DrawCubeWires(hp, 1.05f, 1.05f, 1.05f, BLACK);
+                }
+                EndProfileZone();
+
+                SyncWorld(&snapshot, &world);
+                DispatchJobs(&queryGroup, TraceRayBatchTile, &queryJob, QUERY_RAYS, QUERY_TILE_SIZE);
+                queryInFlight = true;
+
+                // Only chunks in view, not hidden behind solid chunks and not empty get drawn
+                BeginProfileZone("cull");
+                UpdateChunkVisibility(&visibility, &world, camera, (float)GetScreenWidth()/GetScreenHeight());
+                EndProfileZone();
+                SetProfileCounter("chunks visible", visibility.visibleCount);
+                SetProfileCounter("chunks frustum", visibility.frustumCulled);
+                SetProfileCounter("chunks occluded", visibility.occlusionCulled);
+                SetProfileCounter("chunks empty", visibility.emptyCulled);
+
+                for (int i = 0; i < visibility.visibleCount; i++)
+                {
+                    BoundingBox box = GetChunkBox(&world, visibility.visibleList[i]);
+                    if (world.chunks[visibility.visibleList[i]].unknown)
                     {
-                        for (int x=0; x<worldSize; x++)
+                        // Not loaded yet: just its outline, no stall
+                        Vector3 size = Vector3Subtract(box.max, box.min);
+                        DrawCubeWires(Vector3Add(box.min, Vector3Scale(size, 0.5f)), size.x, size.y, size.z, LIGHTGRAY);
+                        continue;
+                    }
+                    for (int z=box.min.z; z<box.max.z; z++)
+                    {
+                        for (int y=box.min.y; y<box.max.y; y++)
                         {
-                            DrawVoxel((Vector3i){x, y, z}, world);
+                            for (int x=box.min.x; x<box.max.x; x++)
+                            {
+                                DrawVoxel((Vector3i){x, y, z}, &world);
+                            }
                         }
                     }
                 }
@@ -333,22 +314,42 @@ int main(void)
                 DrawRay((Ray){startPos, Vector3Subtract(endPos, startPos)}, BLACK);
 
             EndMode3D();
+            EndProfileGpuZone();
 
             DrawFPS(10, 10);
             DrawText(TextFormat("(%.02f, %.02f, %.02f) -> (%.02f, %.02f, %.02f)", startPos.x, startPos.y, startPos.z, endPos.x, endPos.y, endPos.z), 20, 40, 20, BLACK);
+            DrawText(TextFormat("hit (%d, %d, %d) steps flat %d brick %d", brickHit.voxel.x, brickHit.voxel.y, brickHit.voxel.z, flatHit.steps, brickHit.steps), 20, 70, 20, BLACK);
+            DrawText(TextFormat("%d threads, %d/%d query rays hit, %d unknown", GetJobThreadCount(), queryHits, QUERY_RAYS, queryUnknown), 700, 70, 20, BLACK);
+            if (IsWorldSaving()) DrawText(TextFormat("saving %s", saveFile), 700, 100, 20, BLACK);
 
             for(int i=0; i<20; i++)
             {
                 DrawText(TextFormat("(%.04f, %.04f, %.04f)", intersections[i].x, intersections[i].y, intersections[i].z), 20, 100+i*20, 20, BLACK);
                 DrawText(TextFormat("(%d, %d, %d)", intersections2[i].x, intersections2[i].y, intersections2[i].z), 320, 100+i*20, 20, BLACK);
             }
+            if (showProfiler) DrawProfiler(screenWidth - 430, 100);
 
+        EndProfileZone();
+        BeginProfileZone("present");
         EndDrawing();
+        EndProfileZone();
         //----------------------------------------------------------------------------------
+
+        EndProfileFrame();
     }
 
     // De-Initialization
     //--------------------------------------------------------------------------------------
+    UnloadReplay();                     // First, so teardown does not count as replay time
+    if (queryInFlight) WaitJobGroup(&queryGroup);
+    UnloadJobs();
+    UnloadProfiler();
+    UnloadRayBatch(queries);
+    UnloadChunkVisibility(&visibility);
+    UnloadWorld(&snapshot);
+    WaitWorldSave();
+    UnloadWorldStream();
+    UnloadWorld(&world);
     CloseWindow();        // Close window and OpenGL context
     //--------------------------------------------------------------------------------------
 
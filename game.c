@@ -1,126 +1,254 @@
 #include "raylib.h"
 #include "raymath.h"
 
-#include "lua.h"
-#include "lualib.h"
-#include "lauxlib.h"
+#define MESH_IMPLEMENTATION
+#include "mesh.h"
+#define PROFILER_IMPLEMENTATION
+#include "profiler.h"
+#define CULL_IMPLEMENTATION
+#include "cull.h"
+#define HEIGHTMAP_IMPLEMENTATION
+#include "heightmap.h"
 
 #define GLSL_VERSION 330
 
 bool restart = true;
 bool debug = false;
+bool showProfiler = false;  // F1 toggles the zone timings, F2 writes them to profile.json
 
-void DumpLuaStack(lua_State *L)
+typedef enum {
+    RENDER_PER_CUBE = 0,
+    RENDER_INSTANCED,
+    RENDER_MERGED,
+    RENDER_MODE_COUNT
+} RenderMode;
+
+const char *renderModeNames[RENDER_MODE_COUNT] = { "per-cube", "instanced", "merged" };
+RenderMode renderMode = RENDER_MERGED;
+
+// Collect one transform per unit cube of every column so the whole grid can be
+// submitted with a single DrawMeshInstanced call
+int BuildColumnTransforms(Matrix **transforms, const int *heights, int gridWidth, int gridHeight)
 {
-    printf("STACK\n");
-    int top = lua_gettop(L);
-    for (int i = 1; i <= top; i++)
+    int count = 0;
+    for (int i = 0; i < gridWidth * gridHeight; i++)
     {
-        printf("%d\t%s\t", i, luaL_typename(L, i));
-        switch (lua_type(L, i))
-        {
-        case LUA_TNUMBER:
-            printf("%g\n", lua_tonumber(L, i));
-            break;
-        case LUA_TSTRING:
-            printf("%s\n", lua_tostring(L, i));
-            break;
-        case LUA_TBOOLEAN:
-            printf("%s\n", (lua_toboolean(L, i) ? "true" : "false"));
-            break;
-        case LUA_TNIL:
-            printf("%s\n", "nil");
-            break;
-        default:
-            printf("%p\n", lua_topointer(L, i));
-            break;
-        }
+        count += heights[i];
     }
-}
 
-void CalcMeshNormals(Mesh *mesh)
-{
-    float *mv = mesh->vertices;
-    float *mn = mesh->normals;
-    for (int i = 0; i < mesh->vertexCount * 3; i += 9)
+    *transforms = (Matrix *)RL_REALLOC(*transforms, (count > 0 ? count : 1) * sizeof(Matrix));
+
+    int n = 0;
+    for (int x = 0; x < gridWidth; x++)
     {
-        Vector3 v0 = {mv[i + 0], mv[i + 1], mv[i + 2]};
-        Vector3 v1 = {mv[i + 3], mv[i + 4], mv[i + 5]};
-        Vector3 v2 = {mv[i + 6], mv[i + 7], mv[i + 8]};
-        Vector3 tangentA = Vector3Subtract(v1, v0);
-        Vector3 tangentB = Vector3Subtract(v2, v0);
-        Vector3 normal = Vector3Normalize(Vector3CrossProduct(tangentA, tangentB));
-
-        mn[i + 0] = normal.x;
-        mn[i + 1] = normal.y;
-        mn[i + 2] = normal.z;
-        mn[i + 3] = normal.x;
-        mn[i + 4] = normal.y;
-        mn[i + 5] = normal.z;
-        mn[i + 6] = normal.x;
-        mn[i + 7] = normal.y;
-        mn[i + 8] = normal.z;
-
-        for (int j = 0; j < 9; j++)
+        for (int z = 0; z < gridHeight; z++)
         {
-            //printf("normal %d: %.02f\n", i + j, mn[i + j]);
+            for (int y = 0; y < heights[z*gridWidth+x]; y++)
+            {
+                (*transforms)[n++] = MatrixTranslate(x, y, -z-1);
+            }
         }
     }
+
+    return n;
 }
 
-void LoadLuaMesh(Mesh *mesh, const char *filename)
+// Bounds of column (x, z) stacked from cubes with the given local bounds, placed like the
+// draw loops place them
+BoundingBox GetColumnBox(BoundingBox cube, int x, int z, int height)
 {
-    lua_State *L = luaL_newstate();
-    luaL_openlibs(L);
-    int err = luaL_dofile(L, filename);
-    if (err)
+    return (BoundingBox){
+        Vector3Add(cube.min, (Vector3){ x, 0, -z-1 }),
+        Vector3Add(cube.max, (Vector3){ x, height - 1, -z-1 })
+    };
+}
+
+// Growable triangle soup in the same layout LoadLuaMesh produces
+typedef struct MeshBuilder {
+    float *vertices;
+    float *normals;
+    unsigned char *colors;
+    int vertexCount;
+    int capacity;
+} MeshBuilder;
+
+void MeshBuilderAddQuad(MeshBuilder *mb, Vector3 p[4], Vector3 normal, Color color)
+{
+    if (mb->vertexCount + 6 > mb->capacity)
+    {
+        mb->capacity = mb->capacity ? mb->capacity * 2 : 256;
+        mb->vertices = (float *)RL_REALLOC(mb->vertices, mb->capacity * 3 * sizeof(float));
+        mb->normals = (float *)RL_REALLOC(mb->normals, mb->capacity * 3 * sizeof(float));
+        mb->colors = (unsigned char *)RL_REALLOC(mb->colors, mb->capacity * 4 * sizeof(unsigned char));
+    }
+
+    // Wind counter clockwise around the outward normal
+    int order[6] = { 0, 1, 2, 0, 2, 3 };
+    Vector3 cross = Vector3CrossProduct(Vector3Subtract(p[1], p[0]), Vector3Subtract(p[2], p[0]));
+    if (Vector3DotProduct(cross, normal) < 0)
     {
-        printf("LoadLuaMesh error: %s\n", luaL_checkstring(L, -1));
-        return;
+        order[1] = 2; order[2] = 1;
+        order[4] = 3; order[5] = 2;
     }
 
-    lua_getglobal(L, "vertices");
-    lua_len(L, -1);
-    int len = lua_tonumber(L, -1);
-    lua_pop(L, 1);
+    for (int i = 0; i < 6; i++)
+    {
+        Vector3 v = p[order[i]];
+        int n = mb->vertexCount++;
+        mb->vertices[n*3 + 0] = v.x;
+        mb->vertices[n*3 + 1] = v.y;
+        mb->vertices[n*3 + 2] = v.z;
+        mb->normals[n*3 + 0] = normal.x;
+        mb->normals[n*3 + 1] = normal.y;
+        mb->normals[n*3 + 2] = normal.z;
+        mb->colors[n*4 + 0] = color.r;
+        mb->colors[n*4 + 1] = color.g;
+        mb->colors[n*4 + 2] = color.b;
+        mb->colors[n*4 + 3] = color.a;
+    }
+}
 
-    mesh->vertices = (float *)RL_MALLOC(len * sizeof(float));
-    mesh->normals = (float *)RL_MALLOC(len * sizeof(float));
-    mesh->vertexCount = len / 3;
-    mesh->triangleCount = mesh->vertexCount / 3;
+// Sample the height texture through a material map so every draw path binds it
+void SetMaterialHeightTexture(Material *material, Texture2D texture)
+{
+    material->shader.locs[SHADER_LOC_MAP_HEIGHT] = GetShaderLocation(material->shader, "heightMap");
+    material->maps[MATERIAL_MAP_HEIGHT].texture = texture;
+}
 
-    printf("vertexCount: %d\n", mesh->vertexCount);
-    printf("triangleCount: %d\n", mesh->triangleCount);
+bool HeightsSolid(const int *heights, int gridWidth, int x, int y, int z)
+{
+    return y < heights[z*gridWidth + x];
+}
 
-    int i = 0;
-    lua_pushnil(L);
-    while (lua_next(L, -2) != 0)
+// Turn the height grid into a single mesh. Faces between two solid cells are
+// dropped and the remaining coplanar faces are merged into maximal rectangles,
+// sweeping a slice mask along each axis (greedy meshing). Columns are placed
+// exactly where the per-cube loop draws them: cell (x, z) covers [x, x+1] and
+// [-z-1, -z] in world space.
+Mesh GenMeshHeightsGreedy(const int *heights, int gridWidth, int gridHeight)
+{
+    int maxHeight = 0;
+    for (int i = 0; i < gridWidth * gridHeight; i++)
     {
-        float n = lua_tonumber(L, -1);
-        mesh->vertices[i++] = n;
-        lua_pop(L, 1);
-        //printf("vertex %d: %.02f\n", i - 1, n);
+        if (heights[i] > maxHeight) maxHeight = heights[i];
     }
 
-    lua_getglobal(L, "colors");
-    lua_len(L, -1);
-    len = lua_tonumber(L, -1);
-    lua_pop(L, 1);
+    int dims[3] = { gridWidth, maxHeight, gridHeight };
+    int maskSize = 1;
+    for (int d = 0; d < 3; d++)
+    {
+        int size = dims[(d + 1) % 3] * dims[(d + 2) % 3];
+        if (size > maskSize) maskSize = size;
+    }
+    signed char *mask = (signed char *)RL_CALLOC(maskSize, sizeof(signed char));
 
-    mesh->colors = (unsigned char *)RL_MALLOC(len * sizeof(unsigned char));
+    MeshBuilder mb = {0};
 
-    i = 0;
-    lua_pushnil(L);
-    while (lua_next(L, -2) != 0)
+    for (int d = 0; d < 3; d++)
     {
-        unsigned char n = lua_tonumber(L, -1);
-        mesh->colors[i++] = n;
-        //printf("color %d: %d\n", i - 1, n);
-        lua_pop(L, 1);
+        int u = (d + 1) % 3;
+        int v = (d + 2) % 3;
+        int x[3] = {0, 0, 0};
+        int q[3] = {0, 0, 0};
+        q[d] = 1;
+
+        for (x[d] = -1; x[d] < dims[d]; )
+        {
+            // Mark faces on the plane between slice x[d] and x[d]+1.
+            // +1 faces +d (owned by the cell behind), -1 faces -d
+            int n = 0;
+            for (x[v] = 0; x[v] < dims[v]; x[v]++)
+            {
+                for (x[u] = 0; x[u] < dims[u]; x[u]++)
+                {
+                    bool a = x[d] >= 0 && HeightsSolid(heights, gridWidth, x[0], x[1], x[2]);
+                    bool b = x[d] < dims[d] - 1 && HeightsSolid(heights, gridWidth, x[0] + q[0], x[1] + q[1], x[2] + q[2]);
+                    mask[n++] = (a == b) ? 0 : (a ? 1 : -1);
+                }
+            }
+
+            x[d]++;
+
+            // Merge runs of identical mask entries into rectangles
+            n = 0;
+            for (int j = 0; j < dims[v]; j++)
+            {
+                for (int i = 0; i < dims[u]; )
+                {
+                    int c = mask[n];
+                    if (c == 0)
+                    {
+                        i++;
+                        n++;
+                        continue;
+                    }
+
+                    int w = 1;
+                    while (i + w < dims[u] && mask[n + w] == c) w++;
+
+                    int h = 1;
+                    bool done = false;
+                    while (j + h < dims[v])
+                    {
+                        for (int k = 0; k < w; k++)
+                        {
+                            if (mask[n + k + h*dims[u]] != c)
+                            {
+                                done = true;
+                                break;
+                            }
+                        }
+                        if (done) break;
+                        h++;
+                    }
+
+                    x[u] = i;
+                    x[v] = j;
+                    int du[3] = {0, 0, 0};
+                    int dv[3] = {0, 0, 0};
+                    du[u] = w;
+                    dv[v] = h;
+
+                    // Grid space to world space flips z
+                    Vector3 p[4] = {
+                        { x[0], x[1], -x[2] },
+                        { x[0] + du[0], x[1] + du[1], -(x[2] + du[2]) },
+                        { x[0] + du[0] + dv[0], x[1] + du[1] + dv[1], -(x[2] + du[2] + dv[2]) },
+                        { x[0] + dv[0], x[1] + dv[1], -(x[2] + dv[2]) },
+                    };
+                    float sign[3] = { 1, 1, -1 };
+                    Vector3 normal = {0, 0, 0};
+                    if (d == 0) normal.x = c * sign[0];
+                    if (d == 1) normal.y = c * sign[1];
+                    if (d == 2) normal.z = c * sign[2];
+
+                    Color color = normal.y > 0 ? (Color){0, 200, 0, 255} : (Color){204, 204, 179, 255};
+                    MeshBuilderAddQuad(&mb, p, normal, color);
+
+                    for (int l = 0; l < h; l++)
+                    {
+                        for (int k = 0; k < w; k++)
+                        {
+                            mask[n + k + l*dims[u]] = 0;
+                        }
+                    }
+
+                    i += w;
+                    n += w;
+                }
+            }
+        }
     }
 
-    CalcMeshNormals(mesh);
-    UploadMesh(mesh, false);
+    RL_FREE(mask);
+
+    Mesh mesh = {0};
+    mesh.vertices = mb.vertices;
+    mesh.normals = mb.normals;
+    mesh.colors = mb.colors;
+    mesh.vertexCount = mb.vertexCount;
+    mesh.triangleCount = mb.vertexCount / 3;
+    return mesh;
 }
 
 //------------------------------------------------------------------------------------
@@ -133,8 +261,7 @@ int main(void)
     const int screenWidth = 1280;
     const int screenHeight = 720;
 
-    const int gridWidth = 3;
-    const int gridHeight = 3;
+    const int gridSize = 3;
 
     /*
     int heights[9] = {
@@ -144,7 +271,7 @@ int main(void)
     };
     */
 
-    int heights[9] = {
+    int startHeights[9] = {
         1, 1, 1,
         1, 3, 1,
         1, 1, 1
@@ -154,6 +281,7 @@ int main(void)
     {
         InitWindow(screenWidth, screenHeight, "raylib [core] example - 3d camera mode");
         DisableCursor();
+        InitProfiler();
 
         restart = false;
 
@@ -171,31 +299,71 @@ int main(void)
         const char* fs = TextFormat("game.glsl", GLSL_VERSION);
         Shader shader = LoadShader(vs, fs);
 
-        for (int i = 0; i < 9; i++)
+        // Same sources, but matModel comes from the per-instance attribute
+        Shader instancedShader = LoadShader(vs, fs);
+        instancedShader.locs[SHADER_LOC_MATRIX_MODEL] = GetShaderLocationAttrib(instancedShader, "instanceTransform");
+        int instancedOn = 1;
+        SetShaderValue(instancedShader, GetShaderLocation(instancedShader, "instanced"), &instancedOn, SHADER_UNIFORM_INT);
+
+        // Merged terrain sits on the unit lattice, upload it as 8 byte packed vertices
+        Shader packedShader = LoadShader("vertpacked.glsl", fs);
+        MeshPalette palette = {0};
+
+        // Column heights, the shaders sample the GPU copy UploadHeightMap keeps in sync
+        HeightMap map = LoadHeightMap(gridSize);
+        for (int i = 0; i < gridSize * gridSize; i++)
         {
-            int h = heights[i];
-            int loc = GetShaderLocation(shader, TextFormat("heights[%i]", i));
-            SetShaderValue(shader, loc, &h, SHADER_UNIFORM_INT);
-            printf("loc %d %d = %d\n", i, loc, h);
+            SetHeight(&map, i % gridSize, i / gridSize, startHeights[i]);
         }
+        UploadHeightMap(&map);
+        const int *heights = map.heights;
 
+        // Prefer the converted binary mesh (see meshconv), fall back to running the script
+        MeshFile meshFile = {0};
         Mesh mesh = {0};
-        LoadLuaMesh(&mesh, "mesh/cube.lua");
+        if (FileExists("mesh/cube.mesh"))
+        {
+            mesh = LoadMeshBinary("mesh/cube.mesh", &meshFile);
+            if (mesh.vertexCount > 0) UploadMesh(&mesh, false);
+        }
+        if (mesh.vertexCount == 0) LoadLuaMeshEx(&mesh, "mesh/cube.lua", MESH_LOAD_WELD | MESH_LOAD_OPTIMIZE);
         printf("vertexCount: %d\n", mesh.vertexCount);
         printf("triangleCount: %d\n", mesh.triangleCount);
 
         Model model = LoadModelFromMesh(mesh);
         model.materials[0].shader = shader;
+        SetMaterialHeightTexture(&model.materials[0], map.texture);
+
+        BoundingBox cubeBox = GetMeshBoundingBox(mesh);
+
+        Material instancedMaterial = LoadMaterialDefault();
+        instancedMaterial.shader = instancedShader;
+        SetMaterialHeightTexture(&instancedMaterial, map.texture);
+
+        // Rebuilt only when heights change
+        Matrix *transforms = NULL;
+        int transformCount = 0;
+        Model terrain = {0};
+        BoundingBox terrainBox = {0};
+        bool heightsDirty = true;
+
+        // Columns in the view this frame, only those reach the per-cube and instanced draws
+        bool *columnVisible = (bool *)RL_CALLOC(gridSize * gridSize, sizeof(bool));
+        Matrix *visibleTransforms = NULL;
 
         // Main game loop
         while (!WindowShouldClose()) // Detect window close button or ESC or R key
         {
+            BeginProfileFrame();
+
             // Update
             //----------------------------------------------------------------------------------
+            BeginProfileZone("update");
             UpdateCamera(&camera, CAMERA_THIRD_PERSON); // Update camera
 
             if (IsKeyPressed(KEY_R))
             {
+                EndProfileFrame();
                 restart = true;
                 break;
             }
@@ -205,30 +373,137 @@ int main(void)
                 debug = !debug;
             }
 
+            if (IsKeyPressed(KEY_I))
+            {
+                renderMode = (renderMode + 1) % RENDER_MODE_COUNT;
+            }
+
+            // Page up and down raise and lower the column under the camera target, the next
+            // rebuild uploads just that texel
+            if (IsKeyPressed(KEY_PAGE_UP) || IsKeyPressed(KEY_PAGE_DOWN))
+            {
+                int x = (int)floorf(camera.target.x);
+                int z = (int)floorf(-camera.target.z);
+                int height = GetHeight(&map, x, z) + (IsKeyPressed(KEY_PAGE_UP) ? 1 : -1);
+                if (x >= 0 && z >= 0 && x < map.size && z < map.size && height >= 0)
+                {
+                    SetHeight(&map, x, z, height);
+                    heightsDirty = true;
+                }
+            }
+
+            if (IsKeyPressed(KEY_F1)) showProfiler = !showProfiler;
+            if (IsKeyPressed(KEY_F2) && ExportProfileTrace("profile.json")) TraceLog(LOG_INFO, "PROFILER: Trace saved to profile.json");
+
+            if (heightsDirty)
+            {
+                BeginProfileZone("rebuild");
+                transformCount = BuildColumnTransforms(&transforms, heights, gridSize, gridSize);
+                visibleTransforms = (Matrix *)RL_REALLOC(visibleTransforms, (transformCount > 0 ? transformCount : 1) * sizeof(Matrix));
+                terrainBox = GetColumnBox(cubeBox, 0, 0, 1);
+                for (int i = 0; i < gridSize * gridSize; i++)
+                {
+                    BoundingBox box = GetColumnBox(cubeBox, i % gridSize, i / gridSize, heights[i]);
+                    terrainBox.min = Vector3Min(terrainBox.min, box.min);
+                    terrainBox.max = Vector3Max(terrainBox.max, box.max);
+                }
+                UploadHeightMap(&map);
+
+                if (terrain.meshCount > 0) UnloadModel(terrain);
+                Mesh terrainMesh = GenMeshHeightsGreedy(heights, gridSize, gridSize);
+                if (WeldMesh(&terrainMesh)) OptimizeMeshVertexCache(&terrainMesh);
+                int vertexCount = terrainMesh.vertexCount;
+                bool packed = UploadMeshPacked(&terrainMesh, 1.0f, &palette);
+                if (!packed) UploadMesh(&terrainMesh, false);
+                terrain = LoadModelFromMesh(terrainMesh);
+                terrain.materials[0].shader = packed ? packedShader : shader;
+                SetMaterialHeightTexture(&terrain.materials[0], map.texture);
+                if (packed) SetShaderPalette(packedShader, &palette, 1.0f);
+                printf("terrain vertexCount: %d (per-cube %d), %d bytes of vertices\n", vertexCount, transformCount * mesh.vertexCount,
+                    vertexCount * (packed ? (int)sizeof(PackedVertex) : 7 * (int)sizeof(float)));
+
+                heightsDirty = false;
+                EndProfileZone();
+            }
+
+            BeginProfileZone("cull");
+            Frustum frustum = GetCameraFrustum(camera, (float)GetScreenWidth()/GetScreenHeight());
+            int visibleColumns = 0;
+            for (int i = 0; i < gridSize * gridSize; i++)
+            {
+                BoundingBox box = GetColumnBox(cubeBox, i % gridSize, i / gridSize, heights[i]);
+                columnVisible[i] = (heights[i] > 0) && IsBoxInFrustum(&frustum, box);
+                visibleColumns += columnVisible[i];
+            }
+            SetProfileCounter("columns visible", visibleColumns);
+            SetProfileCounter("columns culled", gridSize * gridSize - visibleColumns);
+            EndProfileZone();
+            EndProfileZone();
+
             // Draw
             //----------------------------------------------------------------------------------
             BeginDrawing();
+            BeginProfileZone("draw");
 
             ClearBackground(SKYBLUE);
 
+            BeginProfileGpuZone("scene");
             BeginMode3D(camera);
 
-            BeginShaderMode(shader);
+            int drawCalls = 0;
 
-            for (int x = 0; x < gridWidth; x++)
+            if (renderMode == RENDER_MERGED)
             {
-                for (int z = 0 ; z < gridHeight; z++)
+                // One mesh for the whole grid, it can only go as a whole
+                if (IsBoxInFrustum(&frustum, terrainBox))
                 {
-                    //DrawModel(model, (Vector3){x, heights[z*3+x]-1, -z-1}, 1, BLANK);
-
-                    for (int y = 0; y < heights[z*3+x]; y++)
+                    DrawModel(terrain, (Vector3){0, 0, 0}, 1, BLANK);
+                    drawCalls = 1;
+                }
+            }
+            else if (renderMode == RENDER_INSTANCED)
+            {
+                // Same order as BuildColumnTransforms, keep the runs of visible columns
+                int n = 0, visibleCount = 0;
+                for (int x = 0; x < gridSize; x++)
+                {
+                    for (int z = 0; z < gridSize; z++)
                     {
-                        DrawModel(model, (Vector3){x, y, -z-1}, 1, BLANK);
+                        for (int y = 0; y < heights[z*gridSize+x]; y++, n++)
+                        {
+                            if (columnVisible[z*gridSize+x]) visibleTransforms[visibleCount++] = transforms[n];
+                        }
                     }
                 }
+
+                if (visibleCount > 0)
+                {
+                    DrawMeshInstanced(model.meshes[0], instancedMaterial, visibleTransforms, visibleCount);
+                    drawCalls = 1;
+                }
             }
+            else
+            {
+                BeginShaderMode(shader);
+
+                for (int x = 0; x < gridSize; x++)
+                {
+                    for (int z = 0 ; z < gridSize; z++)
+                    {
+                        if (!columnVisible[z*gridSize+x]) continue;
+
+                        //DrawModel(model, (Vector3){x, heights[z*gridSize+x]-1, -z-1}, 1, BLANK);
 
-            EndShaderMode();
+                        for (int y = 0; y < heights[z*gridSize+x]; y++)
+                        {
+                            DrawModel(model, (Vector3){x, y, -z-1}, 1, BLANK);
+                            drawCalls++;
+                        }
+                    }
+                }
+
+                EndShaderMode();
+            }
 
             if (debug)
             {
@@ -248,19 +523,39 @@ int main(void)
             DrawRay((Ray){ {0.5, 1, -0.5}, {1, 1, 1} }, BLACK);
 
             EndMode3D();
+            EndProfileGpuZone();
 
             DrawFPS(10, 10);
+            DrawText(TextFormat("%s: %d cubes, %d draw calls", renderModeNames[renderMode], transformCount, drawCalls), 10, 40, 20, BLACK);
+            if (showProfiler) DrawProfiler(screenWidth - 430, 10);
 
+            EndProfileZone();
+            BeginProfileZone("present");
             EndDrawing();
+            EndProfileZone();
             //----------------------------------------------------------------------------------
+
+            EndProfileFrame();
         }
 
         // De-Initialization
         //--------------------------------------------------------------------------------------
+        RL_FREE(transforms);
+        RL_FREE(visibleTransforms);
+        RL_FREE(columnVisible);
+        UnloadModel(terrain);
+        UnloadShader(packedShader);
+        instancedMaterial.maps[MATERIAL_MAP_HEIGHT].texture = (Texture2D){0}; // Unloaded below, not by the material
+        UnloadMaterial(instancedMaterial); // Also unloads instancedShader
+        UnloadHeightMap(&map);
+        UnloadMeshBinary(&meshFile, &model.meshes[0]);
         UnloadModel(model);
+        UnloadProfiler();
 
         CloseWindow(); // Close window and OpenGL context
     }
 
+    UnloadLuaMeshVM();
+
     return 0;
 }
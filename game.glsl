@@ -6,7 +6,15 @@ in vec4 worldPosition;
 
 out vec4 fragColor;
 
-uniform int heights[9];
+uniform sampler2D heightMap;   // Column heights, one texel per grid cell
+
+// Height of grid cell (x, z), 0 outside the grid
+int columnHeight(ivec2 cell)
+{
+    ivec2 size = textureSize(heightMap, 0);
+    if (any(lessThan(cell, ivec2(0))) || any(greaterThanEqual(cell, size))) return 0;
+    return int(texelFetch(heightMap, cell, 0).r);
+}
 
 void main()
 {
@@ -22,4 +30,13 @@ void main()
     } else {
         fragColor = vec4(0.0, 0.0, 0.0, 1.0);
     }
+
+    // Flat face normal from the screen derivatives, half a step against it lands inside
+    // the column the face belongs to even on the shared walls between cells
+    vec3 normal = normalize(cross(dFdx(worldPosition.xyz), dFdy(worldPosition.xyz)));
+    vec3 inside = worldPosition.xyz - 0.5*normal;
+    float top = float(columnHeight(ivec2(floor(inside.x), floor(-inside.z))));
+
+    // Columns darken towards their foot so heights read at a glance
+    fragColor.rgb *= mix(0.4, 1.0, clamp(worldPosition.y/max(top, 1.0), 0.0, 1.0));
 }
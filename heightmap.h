@@ -0,0 +1,469 @@
+/**********************************************************************************************
+*
+*   heightmap - Column heights on a square grid, mirrored into a GPU texture
+*
+*   The CPU array is the source of truth. Shaders read the same data from an R32 float
+*   texture with one texel per cell (texel (x, z) is column x of row z). SetHeight records
+*   the rectangle of cells changed since the last upload and UploadHeightMap sends just
+*   that rectangle, so an edit costs one small texture update whatever the map size.
+*
+*   A max-mip pyramid sits on top: level k holds, for every 2^k x 2^k block of columns,
+*   the tallest one. Shadow rays walk the pyramid, skipping whole blocks they pass above
+*   and descending only where they might hit, so a ray over open terrain costs about
+*   log(size) steps instead of one per cell. The levels above 0 are packed into a second
+*   texture of (P/2) x P texels, P being the map size rounded up to a power of two:
+*
+*       level k >= 1 starts at texel (0, P - (P >> (k - 1))) and is (P >> k) texels square
+*
+*   Cells past the map edge (up to P) count as height 0.
+*
+*   ExportHeightMap writes the heights run length encoded, row by row: a HeightMapFileHeader
+*   and then runCount { height, length } pairs. Terrain is mostly stretches of equal columns,
+*   a flat map is a single run. LoadHeightMapFile reads it back and rebuilds the pyramid, the
+*   GPU copies are created by the next UploadHeightMap as usual. Maps are small next to a
+*   World (one int per column), so both run on the calling thread.
+*
+*   CONFIGURATION:
+*
+*   #define HEIGHTMAP_IMPLEMENTATION
+*       Generates the implementation of the library into the included file.
+*       Only ONE file should hold the implementation.
+*
+**********************************************************************************************/
+
+#ifndef HEIGHTMAP_H
+#define HEIGHTMAP_H
+
+#include "raylib.h"
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define HEIGHTMAP_FILE_MAGIC    0x50414d48      // "HMAP"
+#define HEIGHTMAP_FILE_VERSION  1
+#define HEIGHTMAP_FILE_MAX_SIZE 16384           // Cells per side LoadHeightMapFile accepts
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct HeightMapFileHeader {
+    unsigned int magic;
+    unsigned int version;
+    int size;                   // HeightMap.size
+    int runCount;               // { height, length } pairs that follow, host byte order
+} HeightMapFileHeader;
+
+typedef struct HeightMap {
+    int size;                   // Cells per side
+    int *heights;               // size*size column heights, row major by z
+    int mipLevels;              // Pyramid levels above the heights, log2 of size rounded up
+    int *mips;                  // Max heights of levels 1..mipLevels in the atlas layout above
+    Texture2D texture;          // GPU copy, created by the first UploadHeightMap
+    Texture2D mipTexture;       // GPU copy of mips
+    int dirtyMinX;              // Cells changed since the last upload, empty when min > max
+    int dirtyMinZ;
+    int dirtyMaxX;
+    int dirtyMaxZ;
+} HeightMap;
+
+// Pyramid node a shadow ray visited, for debug drawing
+typedef struct HeightMapNode {
+    int level;                  // Node covers 2^level cells per side
+    int x;                      // Node coordinates at that level
+    int z;
+    float t;                    // Horizontal distance along the ray where it entered
+    float height;               // Ray height there
+    bool skipped;               // The ray passed over the node
+} HeightMapNode;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+HeightMap LoadHeightMap(int size);                          // All columns 0, nothing on the GPU yet
+void UnloadHeightMap(HeightMap *map);                       // Free the heights and the texture
+HeightMap LoadHeightMapFile(const char *fileName);          // Heights written by ExportHeightMap, size 0 when unreadable
+bool ExportHeightMap(const HeightMap *map, const char *fileName);   // Write the heights run length encoded
+int GetHeight(const HeightMap *map, int x, int z);          // Column height, 0 outside the map
+void SetHeight(HeightMap *map, int x, int z, int height);   // Change a column, ignored outside the map
+void UploadHeightMap(HeightMap *map);                       // Create the textures or update their dirty rectangles
+int GetHeightMapMax(const HeightMap *map, int level, int x, int z);     // Tallest column under a pyramid node
+bool TraceHeightMapShadow(const HeightMap *map, Vector3 from, Vector3 to, HeightMapNode *nodes, int maxNodes, int *nodeCount);   // True when a column blocks from -> to, nodeCount counts every visit, the first maxNodes are stored
+bool TraceHeightMapShadowFlat(const HeightMap *map, Vector3 from, Vector3 to, int *steps);    // Same answer walking every cell, reference for TraceHeightMapShadow
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HEIGHTMAP_H
+
+/***********************************************************************************
+*
+*   HEIGHTMAP IMPLEMENTATION
+*
+************************************************************************************/
+
+#if defined(HEIGHTMAP_IMPLEMENTATION) && !defined(HEIGHTMAP_IMPLEMENTED)
+#define HEIGHTMAP_IMPLEMENTED
+
+#include <math.h>
+#include <stdio.h>
+
+static void HeightMapClean(HeightMap *map)
+{
+    map->dirtyMinX = map->size;
+    map->dirtyMinZ = map->size;
+    map->dirtyMaxX = -1;
+    map->dirtyMaxZ = -1;
+}
+
+// Side of the pyramid base, the size rounded up to a power of two
+static inline int HeightMapBase(const HeightMap *map)
+{
+    return 1 << map->mipLevels;
+}
+
+// Where node (x, z) of level >= 1 lives in the mip atlas
+static inline int HeightMapMipIndex(const HeightMap *map, int level, int x, int z)
+{
+    int p = HeightMapBase(map);
+    return (p - (p >> (level - 1)) + z) * (p / 2) + x;
+}
+
+HeightMap LoadHeightMap(int size)
+{
+    HeightMap map = { 0 };
+    map.size = size;
+    map.heights = (int *)RL_CALLOC(size * size, sizeof(int));
+    while ((1 << map.mipLevels) < size) map.mipLevels++;
+    if (map.mipLevels > 0) map.mips = (int *)RL_CALLOC((HeightMapBase(&map) / 2) * HeightMapBase(&map), sizeof(int));
+    HeightMapClean(&map);
+    return map;
+}
+
+void UnloadHeightMap(HeightMap *map)
+{
+    if (map->texture.id > 0) UnloadTexture(map->texture);
+    if (map->mipTexture.id > 0) UnloadTexture(map->mipTexture);
+    RL_FREE(map->heights);
+    RL_FREE(map->mips);
+    map->heights = NULL;
+    map->mips = NULL;
+    map->texture = (Texture2D){ 0 };
+    map->mipTexture = (Texture2D){ 0 };
+    map->size = 0;
+    map->mipLevels = 0;
+}
+
+HeightMap LoadHeightMapFile(const char *fileName)
+{
+    FILE *file = fopen(fileName, "rb");
+    if (file == NULL)
+    {
+        TraceLog(LOG_WARNING, "HEIGHTMAP: [%s] Failed to open file", fileName);
+        return (HeightMap){ 0 };
+    }
+
+    HeightMapFileHeader header = { 0 };
+    bool ok = (fread(&header, sizeof(header), 1, file) == 1) && (header.magic == HEIGHTMAP_FILE_MAGIC) &&
+        (header.version == HEIGHTMAP_FILE_VERSION) && (header.size >= 1) && (header.size <= HEIGHTMAP_FILE_MAX_SIZE) &&
+        (header.runCount >= 1) && (header.runCount <= header.size*header.size);
+
+    int (*runs)[2] = ok ? (int (*)[2])RL_MALLOC(header.runCount*sizeof(runs[0])) : NULL;
+    ok = ok && (fread(runs, sizeof(runs[0]), header.runCount, file) == (size_t)header.runCount);
+    fclose(file);
+
+    HeightMap map = ok ? LoadHeightMap(header.size) : (HeightMap){ 0 };
+    int cell = 0;
+    for (int r = 0; r < header.runCount && ok; r++)
+    {
+        ok = (runs[r][0] >= 0) && (runs[r][1] >= 1) && (runs[r][1] <= header.size*header.size - cell);
+        for (int k = 0; k < runs[r][1] && ok; k++, cell++)
+        {
+            SetHeight(&map, cell % header.size, cell / header.size, runs[r][0]);
+        }
+    }
+    RL_FREE(runs);
+
+    if (!ok || cell != header.size*header.size)
+    {
+        TraceLog(LOG_WARNING, "HEIGHTMAP: [%s] Not a height map file", fileName);
+        UnloadHeightMap(&map);
+        return (HeightMap){ 0 };
+    }
+    return map;
+}
+
+bool ExportHeightMap(const HeightMap *map, const char *fileName)
+{
+    int cells = map->size*map->size;
+    int (*runs)[2] = (int (*)[2])RL_MALLOC((cells > 0 ? cells : 1)*sizeof(runs[0]));
+    int runCount = 0;
+    for (int i = 0; i < cells; i++)
+    {
+        if (runCount > 0 && runs[runCount - 1][0] == map->heights[i]) runs[runCount - 1][1]++;
+        else
+        {
+            runs[runCount][0] = map->heights[i];
+            runs[runCount][1] = 1;
+            runCount++;
+        }
+    }
+
+    HeightMapFileHeader header = { HEIGHTMAP_FILE_MAGIC, HEIGHTMAP_FILE_VERSION, map->size, runCount };
+    FILE *file = fopen(fileName, "wb");
+    bool ok = (file != NULL) && (fwrite(&header, sizeof(header), 1, file) == 1) &&
+        (fwrite(runs, sizeof(runs[0]), runCount, file) == (size_t)runCount);
+    if (file && fclose(file) != 0) ok = false;
+    RL_FREE(runs);
+
+    if (!ok) TraceLog(LOG_WARNING, "HEIGHTMAP: [%s] Failed to write file", fileName);
+    return ok;
+}
+
+int GetHeightMapMax(const HeightMap *map, int level, int x, int z)
+{
+    if (level == 0) return GetHeight(map, x, z);
+
+    int side = HeightMapBase(map) >> level;
+    if (x < 0 || z < 0 || x >= side || z >= side) return 0;
+    return map->mips[HeightMapMipIndex(map, level, x, z)];
+}
+
+int GetHeight(const HeightMap *map, int x, int z)
+{
+    if (x < 0 || z < 0 || x >= map->size || z >= map->size) return 0;
+    return map->heights[z*map->size + x];
+}
+
+void SetHeight(HeightMap *map, int x, int z, int height)
+{
+    if (x < 0 || z < 0 || x >= map->size || z >= map->size) return;
+    if (map->heights[z*map->size + x] == height) return;
+
+    map->heights[z*map->size + x] = height;
+
+    // Refresh the maxima above it, stopping as soon as one level comes out unchanged
+    for (int level = 1; level <= map->mipLevels; level++)
+    {
+        int px = x >> level;
+        int pz = z >> level;
+        int m = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            int h = GetHeightMapMax(map, level - 1, px*2 + (i & 1), pz*2 + (i >> 1));
+            if (h > m) m = h;
+        }
+
+        int *node = &map->mips[HeightMapMipIndex(map, level, px, pz)];
+        if (*node == m) break;
+        *node = m;
+    }
+
+    if (x < map->dirtyMinX) map->dirtyMinX = x;
+    if (z < map->dirtyMinZ) map->dirtyMinZ = z;
+    if (x > map->dirtyMaxX) map->dirtyMaxX = x;
+    if (z > map->dirtyMaxZ) map->dirtyMaxZ = z;
+}
+
+// Integer heights become R32 float texels, heights stay exact up to 2^24
+static Texture2D HeightMapLoadTexture(const int *values, int width, int height)
+{
+    float *texels = (float *)RL_MALLOC(width * height * sizeof(float));
+    for (int i = 0; i < width * height; i++)
+    {
+        texels[i] = (float)values[i];
+    }
+
+    Image image = { texels, width, height, 1, PIXELFORMAT_UNCOMPRESSED_R32 };
+    Texture2D texture = LoadTextureFromImage(image);
+    SetTextureFilter(texture, TEXTURE_FILTER_POINT);
+    RL_FREE(texels);
+
+    return texture;
+}
+
+static void HeightMapUpdateTexture(Texture2D texture, const int *values, int stride, int x, int y, int w, int h)
+{
+    float *texels = (float *)RL_MALLOC(w * h * sizeof(float));
+    for (int j = 0; j < h; j++)
+    {
+        for (int i = 0; i < w; i++)
+        {
+            texels[j*w + i] = (float)values[(y + j)*stride + x + i];
+        }
+    }
+
+    UpdateTextureRec(texture, (Rectangle){ x, y, w, h }, texels);
+    RL_FREE(texels);
+}
+
+void UploadHeightMap(HeightMap *map)
+{
+    int p = HeightMapBase(map);
+
+    if (map->texture.id == 0)
+    {
+        map->texture = HeightMapLoadTexture(map->heights, map->size, map->size);
+        if (map->mipLevels > 0) map->mipTexture = HeightMapLoadTexture(map->mips, p/2, p);
+    }
+    else if (map->dirtyMinX <= map->dirtyMaxX)
+    {
+        HeightMapUpdateTexture(map->texture, map->heights, map->size, map->dirtyMinX, map->dirtyMinZ,
+            map->dirtyMaxX - map->dirtyMinX + 1, map->dirtyMaxZ - map->dirtyMinZ + 1);
+
+        // The changed nodes of each level lie under the same rectangle scaled down
+        for (int level = 1; level <= map->mipLevels; level++)
+        {
+            int minX = map->dirtyMinX >> level, maxX = map->dirtyMaxX >> level;
+            int minZ = map->dirtyMinZ >> level, maxZ = map->dirtyMaxZ >> level;
+            HeightMapUpdateTexture(map->mipTexture, map->mips, p/2, minX, p - (p >> (level - 1)) + minZ,
+                maxX - minX + 1, maxZ - minZ + 1);
+        }
+    }
+
+    HeightMapClean(map);
+}
+
+bool TraceHeightMapShadow(const HeightMap *map, Vector3 from, Vector3 to, HeightMapNode *nodes, int maxNodes, int *nodeCount)
+{
+    if (nodeCount) *nodeCount = 0;
+
+    float dx = to.x - from.x;
+    float dz = to.z - from.z;
+    float tMax = sqrtf(dx*dx + dz*dz);
+    if (tMax < 1e-6f) return false;
+
+    // t is horizontal distance from 'from', the ray climbs 'slope' per unit of t
+    float dirX = dx / tMax;
+    float dirZ = dz / tMax;
+    float slope = (to.y - from.y) / tMax;
+    int stepX = (dirX < 0) ? -1 : 1;
+    int stepZ = (dirZ < 0) ? -1 : 1;
+    float invX = stepX / fmaxf(fabsf(dirX), 1e-20f);
+    float invZ = stepZ / fmaxf(fabsf(dirZ), 1e-20f);
+    int p = HeightMapBase(map);
+
+    // Leave the starting column first, the surface being lit belongs to it
+    int x = (int)floorf(from.x);
+    int z = (int)floorf(from.z);
+    float tx = (x + (stepX > 0) - from.x) * invX;
+    float tz = (z + (stepZ > 0) - from.z) * invZ;
+    float t = fminf(tx, tz);
+    if (tx < tz) x += stepX;
+    else z += stepZ;
+    int level = 0;
+
+    // Nodes are tracked as integers so every skip moves at least one node forward
+    while (t < tMax)
+    {
+        // Past the pyramid and heading further out, nothing left to hit
+        int side = p >> level;
+        if ((x < 0 && stepX < 0) || (z < 0 && stepZ < 0) || (x >= side && stepX > 0) || (z >= side && stepZ > 0)) break;
+
+        float size = (float)(1 << level);
+        tx = ((x + (stepX > 0)) * size - from.x) * invX;
+        tz = ((z + (stepZ > 0)) * size - from.z) * invZ;
+        float tExit = fminf(tx, tz);
+
+        // The ray is lowest where it enters the node when climbing, where it leaves otherwise
+        float rayMin = from.y + slope * ((slope >= 0) ? t : fminf(tExit, tMax));
+        bool above = rayMin >= GetHeightMapMax(map, level, x, z) - 1;
+
+        if (nodeCount)
+        {
+            if (nodes && *nodeCount < maxNodes) nodes[*nodeCount] = (HeightMapNode){ level, x, z, t, from.y + slope * t, above };
+            (*nodeCount)++;
+        }
+
+        if (above)
+        {
+            // Step to the neighbour, trying its parent next only if that is a different node
+            // than the one just descended from (>> floors negative nodes too)
+            int nx = x, nz = z;
+            if (tx < tz) nx += stepX;
+            else nz += stepZ;
+            t = fmaxf(t, tExit);
+            if (level < map->mipLevels && ((nx >> 1) != (x >> 1) || (nz >> 1) != (z >> 1)))
+            {
+                level++;
+                nx >>= 1;
+                nz >>= 1;
+            }
+            x = nx;
+            z = nz;
+        }
+        else if (level == 0) return true;
+        else
+        {
+            // Descend into the child the ray is in at t, past any it already left by rounding
+            level--;
+            size *= 0.5f;
+            int cx = (int)floorf((from.x + dirX * t) / size);
+            int cz = (int)floorf((from.z + dirZ * t) / size);
+            cx = (cx < x*2) ? x*2 : (cx > x*2 + 1) ? x*2 + 1 : cx;
+            cz = (cz < z*2) ? z*2 : (cz > z*2 + 1) ? z*2 + 1 : cz;
+            for (int i = 0; i < 2; i++)
+            {
+                tx = ((cx + (stepX > 0)) * size - from.x) * invX;
+                tz = ((cz + (stepZ > 0)) * size - from.z) * invZ;
+                if (tx <= t && tx <= tz && (cx + stepX) >> 1 == x) cx += stepX;
+                else if (tz <= t && (cz + stepZ) >> 1 == z) cz += stepZ;
+            }
+            x = cx;
+            z = cz;
+        }
+    }
+
+    return false;
+}
+
+bool TraceHeightMapShadowFlat(const HeightMap *map, Vector3 from, Vector3 to, int *steps)
+{
+    if (steps) *steps = 0;
+
+    float dx = to.x - from.x;
+    float dz = to.z - from.z;
+    float tMax = sqrtf(dx*dx + dz*dz);
+    if (tMax < 1e-6f) return false;
+
+    float dirX = dx / tMax;
+    float dirZ = dz / tMax;
+    float slope = (to.y - from.y) / tMax;
+    int stepX = (dirX < 0) ? -1 : 1;
+    int stepZ = (dirZ < 0) ? -1 : 1;
+    float invX = stepX / fmaxf(fabsf(dirX), 1e-20f);
+    float invZ = stepZ / fmaxf(fabsf(dirZ), 1e-20f);
+
+    int x = (int)floorf(from.x);
+    int z = (int)floorf(from.z);
+    float tx = (x + (stepX > 0) - from.x) * invX;
+    float tz = (z + (stepZ > 0) - from.z) * invZ;
+    float t = fminf(tx, tz);
+    if (tx < tz) x += stepX;
+    else z += stepZ;
+
+    while (t < tMax)
+    {
+        if ((x < 0 && stepX < 0) || (z < 0 && stepZ < 0) || (x >= map->size && stepX > 0) || (z >= map->size && stepZ > 0)) break;
+        if (steps) (*steps)++;
+
+        tx = (x + (stepX > 0) - from.x) * invX;
+        tz = (z + (stepZ > 0) - from.z) * invZ;
+        float tExit = fminf(tx, tz);
+
+        float rayMin = from.y + slope * ((slope >= 0) ? t : fminf(tExit, tMax));
+        if (rayMin < GetHeight(map, x, z) - 1) return true;
+
+        if (tx < tz) x += stepX;
+        else z += stepZ;
+        t = fmaxf(t, tExit);
+    }
+
+    return false;
+}
+
+#endif // HEIGHTMAP_IMPLEMENTATION
@@ -0,0 +1,310 @@
+/**********************************************************************************************
+*
+*   horizonmap - Per column horizon angles of a HeightMap for directional light shadows
+*
+*   For every cell and each of HORIZON_DIRECTIONS azimuths the map stores how steeply the
+*   terrain rises in that direction, as the tangent of the highest elevation angle any column
+*   reaches seen from the top of the cell (0 when nothing rises above it). A sun whose
+*   elevation tangent is not above the horizon of the cell, interpolated between the two
+*   nearest azimuths, is blocked. The shadow test is one texture fetch and a compare, no
+*   ray walk, whatever the map size.
+*
+*   Horizons are measured from the top of the column, side faces use the value of their own
+*   column, which is exact for top faces and an approximation for walls.
+*
+*   Building the map walks one ray per cell and azimuth, split over the jobs.h workers, so
+*   InitJobs has to be called first. When a column changes, UpdateHorizonMap recomputes only
+*   the cells whose rays cross it: for each azimuth a one or two cell wide band running from
+*   the column back to the map edge.
+*
+*   The GPU copy is an RGBA32F texture of (size*HORIZON_DIRECTIONS/4) x size texels, azimuth
+*   k of cell (x, z) being component k%4 of texel (x*HORIZON_DIRECTIONS/4 + k/4, z).
+*   Azimuth k points along (cos(a), sin(a)) in the xz plane, a = 2*PI*k/HORIZON_DIRECTIONS.
+*
+*   CONFIGURATION:
+*
+*   #define HORIZONMAP_IMPLEMENTATION
+*       Generates the implementation of the library into the included file.
+*       Only ONE file should hold the implementation.
+*
+**********************************************************************************************/
+
+#ifndef HORIZONMAP_H
+#define HORIZONMAP_H
+
+#include "raylib.h"
+#include "heightmap.h"
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define HORIZON_DIRECTIONS  16      // Azimuths per cell, multiple of 4 (one RGBA texel holds 4)
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct HorizonMap {
+    int size;                   // Cells per side, same as the HeightMap
+    float *tangents;            // size*size*HORIZON_DIRECTIONS horizon tangents, cell major, cells row major by z
+    Vector2 directions[HORIZON_DIRECTIONS];     // Unit xz vector of every azimuth
+    Texture2D texture;          // GPU copy, created by the first UploadHorizonMap
+    int dirtyMinX;              // Cells changed since the last upload, empty when min > max
+    int dirtyMinZ;
+    int dirtyMaxX;
+    int dirtyMaxZ;
+} HorizonMap;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+HorizonMap LoadHorizonMap(const HeightMap *map);            // Compute every cell on the job workers
+void UnloadHorizonMap(HorizonMap *horizon);                 // Free the tangents and the texture
+void UpdateHorizonMap(HorizonMap *horizon, const HeightMap *map, int x, int z);    // Recompute the cells whose rays cross column (x, z), call after changing it
+void UploadHorizonMap(HorizonMap *horizon);                 // Create the texture or update its dirty rectangle
+float GetHorizon(const HorizonMap *horizon, int x, int z, float azimuth);         // Horizon tangent towards azimuth (radians), 0 outside the map
+bool IsHorizonShadowed(const HorizonMap *horizon, int x, int z, Vector3 lightDir); // True when the terrain hides a sun shining from lightDir
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HORIZONMAP_H
+
+/***********************************************************************************
+*
+*   HORIZONMAP IMPLEMENTATION
+*
+************************************************************************************/
+
+#if defined(HORIZONMAP_IMPLEMENTATION) && !defined(HORIZONMAP_IMPLEMENTED)
+#define HORIZONMAP_IMPLEMENTED
+
+#include <math.h>
+
+#include "jobs.h"
+
+typedef struct HorizonJob {
+    HorizonMap *horizon;
+    const HeightMap *map;
+    int maxHeight;              // Tallest column of the map, bounds what is left of a walk
+    const int *tasks;           // Cell*HORIZON_DIRECTIONS + azimuth to compute, NULL for all of them
+} HorizonJob;
+
+static void HorizonClean(HorizonMap *horizon)
+{
+    horizon->dirtyMinX = horizon->size;
+    horizon->dirtyMinZ = horizon->size;
+    horizon->dirtyMaxX = -1;
+    horizon->dirtyMaxZ = -1;
+}
+
+// Walk the cells along dir from the centre of (x, z), keeping the steepest rise seen. Every
+// column is taken at the distance where the walk enters it, its closest point on the line
+static float HorizonTrace(const HeightMap *map, int x, int z, Vector2 dir, int maxHeight)
+{
+    int size = map->size;
+    int top = map->heights[z*size + x];
+    if (maxHeight <= top) return 0.0f;
+
+    int stepX = (dir.x < 0) ? -1 : 1;
+    int stepZ = (dir.y < 0) ? -1 : 1;
+    float deltaX = 1.0f / fmaxf(fabsf(dir.x), 1e-20f);
+    float deltaZ = 1.0f / fmaxf(fabsf(dir.y), 1e-20f);
+    float tX = 0.5f * deltaX;
+    float tZ = 0.5f * deltaZ;
+    float best = 0.0f;
+
+    for (;;)
+    {
+        float t;
+        if (tX < tZ)
+        {
+            t = tX;
+            tX += deltaX;
+            x += stepX;
+        }
+        else
+        {
+            t = tZ;
+            tZ += deltaZ;
+            z += stepZ;
+        }
+
+        if (x < 0 || z < 0 || x >= size || z >= size) break;
+
+        // Even the tallest column could not beat best from here on
+        if ((float)(maxHeight - top) <= best * t) break;
+
+        float tangent = (map->heights[z*size + x] - top) / t;
+        if (tangent > best) best = tangent;
+    }
+
+    return best;
+}
+
+static void HorizonJobRun(void *data, int begin, int end)
+{
+    HorizonJob *job = (HorizonJob *)data;
+
+    for (int i = begin; i < end; i++)
+    {
+        int task = job->tasks ? job->tasks[i] : i;
+        int cell = task / HORIZON_DIRECTIONS;
+        int k = task % HORIZON_DIRECTIONS;
+        job->horizon->tangents[task] = HorizonTrace(job->map, cell % job->map->size, cell / job->map->size,
+            job->horizon->directions[k], job->maxHeight);
+    }
+}
+
+static void HorizonRun(HorizonMap *horizon, const HeightMap *map, const int *tasks, int count, int tileSize)
+{
+    HorizonJob job = { horizon, map, GetHeightMapMax(map, map->mipLevels, 0, 0), tasks };
+    JobGroup group = { 0 };
+    DispatchJobs(&group, HorizonJobRun, &job, count, tileSize);
+    WaitJobGroup(&group);
+}
+
+HorizonMap LoadHorizonMap(const HeightMap *map)
+{
+    HorizonMap horizon = { 0 };
+    horizon.size = map->size;
+    horizon.tangents = (float *)RL_CALLOC(map->size * map->size * HORIZON_DIRECTIONS, sizeof(float));
+
+    for (int k = 0; k < HORIZON_DIRECTIONS; k++)
+    {
+        float a = 2.0f*PI*k/HORIZON_DIRECTIONS;
+        horizon.directions[k] = (Vector2){ cosf(a), sinf(a) };
+    }
+
+    // One row of cells per job
+    HorizonRun(&horizon, map, NULL, map->size * map->size * HORIZON_DIRECTIONS, map->size * HORIZON_DIRECTIONS);
+
+    horizon.dirtyMinX = 0;
+    horizon.dirtyMinZ = 0;
+    horizon.dirtyMaxX = map->size - 1;
+    horizon.dirtyMaxZ = map->size - 1;
+
+    return horizon;
+}
+
+void UnloadHorizonMap(HorizonMap *horizon)
+{
+    if (horizon->texture.id > 0) UnloadTexture(horizon->texture);
+    RL_FREE(horizon->tangents);
+    horizon->tangents = NULL;
+    horizon->texture = (Texture2D){ 0 };
+    horizon->size = 0;
+}
+
+void UpdateHorizonMap(HorizonMap *horizon, const HeightMap *map, int x, int z)
+{
+    int size = horizon->size;
+    if (x < 0 || z < 0 || x >= size || z >= size) return;
+
+    // Per azimuth the band holds at most 5 cells per step back, the column itself included
+    int *tasks = (int *)RL_MALLOC(HORIZON_DIRECTIONS * size * 5 * sizeof(int));
+    int count = 0;
+
+    for (int k = 0; k < HORIZON_DIRECTIONS; k++)
+    {
+        // Walk back from the column along the major axis u of the azimuth. At each step the
+        // cells whose rays hit the column have their centres between lo and hi on the minor axis v
+        Vector2 dir = horizon->directions[k];
+        bool xMajor = fabsf(dir.x) >= fabsf(dir.y);
+        float du = xMajor ? dir.x : dir.y;
+        float dv = xMajor ? dir.y : dir.x;
+        int cu = xMajor ? x : z;
+        int cv = xMajor ? z : x;
+        int stepU = (du < 0) ? 1 : -1;
+        float r = dv / du;
+
+        for (int pu = cu; pu >= 0 && pu < size; pu += stepU)
+        {
+            float a = (pu + 0.5f - cu) * r;
+            float b = (pu + 0.5f - cu - 1) * r;
+            float lo = cv + fminf(a, b);
+            float hi = cv + 1 + fmaxf(a, b);
+
+            // Rounded outwards, recomputing a cell too many costs nothing but time
+            int vMin = (int)floorf(lo - 0.5f);
+            int vMax = (int)ceilf(hi - 0.5f);
+            if (vMin < 0) vMin = 0;
+            if (vMax > size - 1) vMax = size - 1;
+
+            for (int pv = vMin; pv <= vMax; pv++)
+            {
+                int px = xMajor ? pu : pv;
+                int pz = xMajor ? pv : pu;
+                tasks[count++] = (pz*size + px)*HORIZON_DIRECTIONS + k;
+
+                if (px < horizon->dirtyMinX) horizon->dirtyMinX = px;
+                if (pz < horizon->dirtyMinZ) horizon->dirtyMinZ = pz;
+                if (px > horizon->dirtyMaxX) horizon->dirtyMaxX = px;
+                if (pz > horizon->dirtyMaxZ) horizon->dirtyMaxZ = pz;
+            }
+        }
+    }
+
+    HorizonRun(horizon, map, tasks, count, 256);
+    RL_FREE(tasks);
+}
+
+void UploadHorizonMap(HorizonMap *horizon)
+{
+    int texelsPerCell = HORIZON_DIRECTIONS/4;
+
+    if (horizon->texture.id == 0)
+    {
+        Image image = { horizon->tangents, horizon->size * texelsPerCell, horizon->size, 1, PIXELFORMAT_UNCOMPRESSED_R32G32B32A32 };
+        horizon->texture = LoadTextureFromImage(image);
+        SetTextureFilter(horizon->texture, TEXTURE_FILTER_POINT);
+    }
+    else if (horizon->dirtyMinX <= horizon->dirtyMaxX)
+    {
+        int w = horizon->dirtyMaxX - horizon->dirtyMinX + 1;
+        int h = horizon->dirtyMaxZ - horizon->dirtyMinZ + 1;
+        int rowFloats = w * HORIZON_DIRECTIONS;
+        float *texels = (float *)RL_MALLOC(rowFloats * h * sizeof(float));
+        for (int j = 0; j < h; j++)
+        {
+            const float *row = &horizon->tangents[((horizon->dirtyMinZ + j)*horizon->size + horizon->dirtyMinX)*HORIZON_DIRECTIONS];
+            for (int i = 0; i < rowFloats; i++) texels[j*rowFloats + i] = row[i];
+        }
+
+        UpdateTextureRec(horizon->texture, (Rectangle){ horizon->dirtyMinX * texelsPerCell, horizon->dirtyMinZ, w * texelsPerCell, h }, texels);
+        RL_FREE(texels);
+    }
+
+    HorizonClean(horizon);
+}
+
+float GetHorizon(const HorizonMap *horizon, int x, int z, float azimuth)
+{
+    if (x < 0 || z < 0 || x >= horizon->size || z >= horizon->size) return 0.0f;
+
+    // Blend the two stored azimuths around the requested one
+    float k = azimuth/(2.0f*PI)*HORIZON_DIRECTIONS;
+    k -= floorf(k/HORIZON_DIRECTIONS)*HORIZON_DIRECTIONS;
+    int k0 = (int)k % HORIZON_DIRECTIONS;
+    int k1 = (k0 + 1) % HORIZON_DIRECTIONS;
+    float f = k - floorf(k);
+
+    const float *cell = &horizon->tangents[(z*horizon->size + x)*HORIZON_DIRECTIONS];
+    return cell[k0] + (cell[k1] - cell[k0])*f;
+}
+
+bool IsHorizonShadowed(const HorizonMap *horizon, int x, int z, Vector3 lightDir)
+{
+    if (lightDir.y <= 0) return true;
+
+    float horizontal = sqrtf(lightDir.x*lightDir.x + lightDir.z*lightDir.z);
+    if (horizontal < 1e-6f) return false;
+
+    return lightDir.y/horizontal <= GetHorizon(horizon, x, z, atan2f(lightDir.z, lightDir.x));
+}
+
+#endif // HORIZONMAP_IMPLEMENTATION
@@ -0,0 +1,312 @@
+/**********************************************************************************************
+*
+*   jobs - Work stealing job system
+*
+*   One worker thread per core (the thread calling InitJobs counts as worker 0). Every
+*   worker owns a Chase-Lev deque: it pushes and pops jobs at the bottom, idle workers steal
+*   from the top of a random victim. Work is submitted as a range that gets split into
+*   tiles, each tile is one job. A JobGroup counts the tiles still pending so the submitter
+*   can poll it (IsJobGroupDone) or help out until it completes (WaitJobGroup).
+*
+*   Jobs must only be dispatched from worker threads, which includes the thread that
+*   called InitJobs.
+*
+*   CONFIGURATION:
+*
+*   #define JOBS_IMPLEMENTATION
+*       Generates the implementation of the library into the included file.
+*       Only ONE file should hold the implementation.
+*
+**********************************************************************************************/
+
+#ifndef JOBS_H
+#define JOBS_H
+
+#include "raylib.h"
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define MAX_JOB_THREADS     64
+#define JOB_QUEUE_SIZE      4096    // Jobs per worker deque, must be a power of 2
+#define JOB_WAIT_SPINS      64      // Failed steals WaitJobGroup spins through before it yields
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef void (*JobFunc)(void *data, int begin, int end);
+
+typedef struct JobGroup {
+    int pending;            // Tiles not finished yet, accessed atomically
+} JobGroup;
+
+typedef struct Job {
+    JobFunc func;
+    void *data;
+    int begin;
+    int end;
+    JobGroup *group;
+} Job;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+void InitJobs(int threadCount);                 // Start workers, threadCount <= 0 uses one per core
+void UnloadJobs(void);                          // Stop and join the workers
+int GetJobThreadCount(void);                    // Workers including the calling thread
+int GetCpuCount(void);
+void DispatchJobs(JobGroup *group, JobFunc func, void *data, int count, int tileSize);  // Split [0, count) into tiles
+bool IsJobGroupDone(JobGroup *group);
+void WaitJobGroup(JobGroup *group);             // Run jobs on this thread until the group is done
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JOBS_H
+
+/***********************************************************************************
+*
+*   JOBS IMPLEMENTATION
+*
+************************************************************************************/
+
+#if defined(JOBS_IMPLEMENTATION) && !defined(JOBS_IMPLEMENTED)
+#define JOBS_IMPLEMENTED
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+typedef struct JobQueue {
+    long top;               // Next job to steal
+    long bottom;            // Next free slot for the owner
+    Job jobs[JOB_QUEUE_SIZE];
+} JobQueue;
+
+static struct {
+    int threadCount;
+    pthread_t threads[MAX_JOB_THREADS];
+    JobQueue *queues;
+    int queued;             // Jobs sitting in any deque
+    int quit;
+    pthread_mutex_t lock;   // Only used to park idle workers
+    pthread_cond_t wake;
+} jobs = {0};
+
+static __thread int jobThreadIndex = 0;
+
+static bool JobQueuePush(JobQueue *q, Job job)
+{
+    long b = __atomic_load_n(&q->bottom, __ATOMIC_RELAXED);
+    long t = __atomic_load_n(&q->top, __ATOMIC_ACQUIRE);
+    if (b - t >= JOB_QUEUE_SIZE) return false;
+
+    q->jobs[b & (JOB_QUEUE_SIZE - 1)] = job;
+    __atomic_store_n(&q->bottom, b + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+static bool JobQueuePop(JobQueue *q, Job *job)
+{
+    long b = __atomic_load_n(&q->bottom, __ATOMIC_RELAXED) - 1;
+    __atomic_store_n(&q->bottom, b, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    long t = __atomic_load_n(&q->top, __ATOMIC_RELAXED);
+
+    if (t > b)
+    {
+        __atomic_store_n(&q->bottom, b + 1, __ATOMIC_RELAXED);
+        return false;
+    }
+
+    *job = q->jobs[b & (JOB_QUEUE_SIZE - 1)];
+    if (t == b)
+    {
+        // Last job, race the thieves for it
+        bool won = __atomic_compare_exchange_n(&q->top, &t, t + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+        __atomic_store_n(&q->bottom, b + 1, __ATOMIC_RELAXED);
+        return won;
+    }
+    return true;
+}
+
+static bool JobQueueSteal(JobQueue *q, Job *job)
+{
+    long t = __atomic_load_n(&q->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    long b = __atomic_load_n(&q->bottom, __ATOMIC_ACQUIRE);
+    if (t >= b) return false;
+
+    *job = q->jobs[t & (JOB_QUEUE_SIZE - 1)];
+    return __atomic_compare_exchange_n(&q->top, &t, t + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+}
+
+static void JobRun(Job job)
+{
+    job.func(job.data, job.begin, job.end);
+    __atomic_fetch_sub(&job.group->pending, 1, __ATOMIC_RELEASE);
+}
+
+// Own deque first, then try every other worker starting from a random one
+static bool JobFind(int self, unsigned int *seed, Job *job)
+{
+    if (JobQueuePop(&jobs.queues[self], job)) goto found;
+
+    *seed = *seed * 1103515245u + 12345u;
+    int start = (*seed >> 16) % jobs.threadCount;
+    for (int i = 0; i < jobs.threadCount; i++)
+    {
+        int victim = (start + i) % jobs.threadCount;
+        if (victim != self && JobQueueSteal(&jobs.queues[victim], job)) goto found;
+    }
+    return false;
+
+found:
+    __atomic_fetch_sub(&jobs.queued, 1, __ATOMIC_RELAXED);
+    return true;
+}
+
+static void *JobWorker(void *arg)
+{
+    int self = (int)(intptr_t)arg;
+    unsigned int seed = self * 7919u;
+    jobThreadIndex = self;
+
+    while (!__atomic_load_n(&jobs.quit, __ATOMIC_ACQUIRE))
+    {
+        Job job;
+        if (JobFind(self, &seed, &job))
+        {
+            JobRun(job);
+            continue;
+        }
+
+        pthread_mutex_lock(&jobs.lock);
+        while (__atomic_load_n(&jobs.queued, __ATOMIC_ACQUIRE) == 0 && !__atomic_load_n(&jobs.quit, __ATOMIC_ACQUIRE))
+        {
+            pthread_cond_wait(&jobs.wake, &jobs.lock);
+        }
+        pthread_mutex_unlock(&jobs.lock);
+    }
+
+    return NULL;
+}
+
+int GetCpuCount(void)
+{
+#if defined(_WIN32)
+    int count = pthread_num_processors_np();
+#else
+    int count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return count > 0 ? count : 1;
+}
+
+void InitJobs(int threadCount)
+{
+    if (threadCount <= 0) threadCount = GetCpuCount();
+    if (threadCount > MAX_JOB_THREADS) threadCount = MAX_JOB_THREADS;
+
+    jobs.threadCount = threadCount;
+    jobs.queues = (JobQueue *)RL_CALLOC(threadCount, sizeof(JobQueue));
+    jobs.queued = 0;
+    jobs.quit = 0;
+    pthread_mutex_init(&jobs.lock, NULL);
+    pthread_cond_init(&jobs.wake, NULL);
+
+    jobThreadIndex = 0;
+    for (int i = 1; i < threadCount; i++)
+    {
+        pthread_create(&jobs.threads[i], NULL, JobWorker, (void *)(intptr_t)i);
+    }
+}
+
+void UnloadJobs(void)
+{
+    pthread_mutex_lock(&jobs.lock);
+    __atomic_store_n(&jobs.quit, 1, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&jobs.wake);
+    pthread_mutex_unlock(&jobs.lock);
+
+    for (int i = 1; i < jobs.threadCount; i++)
+    {
+        pthread_join(jobs.threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&jobs.wake);
+    pthread_mutex_destroy(&jobs.lock);
+    RL_FREE(jobs.queues);
+    jobs.queues = NULL;
+    jobs.threadCount = 0;
+}
+
+int GetJobThreadCount(void)
+{
+    return jobs.threadCount;
+}
+
+void DispatchJobs(JobGroup *group, JobFunc func, void *data, int count, int tileSize)
+{
+    if (tileSize <= 0) tileSize = 1;
+    __atomic_store_n(&group->pending, (count + tileSize - 1) / tileSize, __ATOMIC_RELAXED);
+
+    JobQueue *q = &jobs.queues[jobThreadIndex];
+    for (int begin = 0; begin < count; begin += tileSize)
+    {
+        Job job = { func, data, begin, (begin + tileSize < count) ? begin + tileSize : count, group };
+
+        // Count it before it becomes visible so thieves never take queued below zero
+        __atomic_fetch_add(&jobs.queued, 1, __ATOMIC_RELEASE);
+        if (!JobQueuePush(q, job))
+        {
+            // Deque full, nobody can take it faster than we can
+            __atomic_fetch_sub(&jobs.queued, 1, __ATOMIC_RELAXED);
+            JobRun(job);
+        }
+    }
+
+    pthread_mutex_lock(&jobs.lock);
+    pthread_cond_broadcast(&jobs.wake);
+    pthread_mutex_unlock(&jobs.lock);
+}
+
+bool IsJobGroupDone(JobGroup *group)
+{
+    return __atomic_load_n(&group->pending, __ATOMIC_ACQUIRE) == 0;
+}
+
+void WaitJobGroup(JobGroup *group)
+{
+    unsigned int seed = 1;
+    int spins = 0;
+    while (!IsJobGroupDone(group))
+    {
+        Job job;
+        if (JobFind(jobThreadIndex, &seed, &job))
+        {
+            JobRun(job);
+            spins = 0;
+            continue;
+        }
+
+        // Nothing left to take, the last tiles are running elsewhere: back off so this
+        // thread doesn't hammer the deques or starve those workers of a core
+        if (spins++ < JOB_WAIT_SPINS)
+        {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+            __builtin_ia32_pause();
+#endif
+        }
+        else sched_yield();
+    }
+}
+
+#endif // JOBS_IMPLEMENTATION
@@ -0,0 +1,533 @@
+/**********************************************************************************************
+*
+*   lightbake - CPU baked shadowing for the exposed faces of HeightMap columns
+*
+*   Collects every voxel face of the columns that is not covered by a neighbour (tops and
+*   walls, bottoms are never lit) into non-indexed meshes, one per LIGHTBAKE_TILE_SIZE^2
+*   columns. BakeLight traces 2x2 shadow rays per face with TraceHeightMapShadow, split over
+*   the jobs.h workers, and writes the lit fraction into the face's vertex colors, so drawing
+*   the result needs no shadow work at all.
+*
+*   The bake remembers the light it was made for: BakeLight returns straight away while the
+*   light stays where it is. After a column changes, UpdateLightBakeColumn regenerates the
+*   faces of that column and its 4 neighbours, re-uploads only the tiles holding them and
+*   retraces, for the same light, just the new faces and those whose rays pass over the
+*   column. UpdateLightBakeGeometry rebuilds everything and leaves the next BakeLight to
+*   trace every face again.
+*
+*   Column voxels are unit cubes spanning [y - 1, y] for y in 0..height-1, like dda2 draws them.
+*
+*   CONFIGURATION:
+*
+*   #define LIGHTBAKE_IMPLEMENTATION
+*       Generates the implementation of the library into the included file.
+*       Only ONE file should hold the implementation.
+*
+**********************************************************************************************/
+
+#ifndef LIGHTBAKE_H
+#define LIGHTBAKE_H
+
+#include "raylib.h"
+#include "heightmap.h"
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define LIGHTBAKE_TILE_SIZE 16                          // Columns per side of each mesh
+#define LIGHTBAKE_LIT       (Color){ 0, 255, 0, 255 }   // Vertex color of a fully lit face
+#define LIGHTBAKE_SHADOWED  (Color){ 0, 64, 0, 255 }    // Vertex color of a face in full shadow
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct BakedFace {
+    short x;                    // Voxel the face belongs to, the cube spans [y - 1, y]
+    short y;
+    short z;
+    short side;                 // 0: +x, 1: -x, 2: +y, 3: +z, 4: -z
+} BakedFace;
+
+// Faces of a square of columns, stored column by column (rows by z)
+typedef struct LightBakeTile {
+    int faceCount;
+    BakedFace *faces;
+    float *visibility;          // Lit fraction of every face, 0..1
+    Mesh mesh;                  // 6 vertices per face, colors carry the visibility
+} LightBakeTile;
+
+typedef struct LightBake {
+    int size;                   // Columns per side, same as the HeightMap
+    int tilesPerSide;
+    LightBakeTile *tiles;       // Rows by z
+    int faceCount;              // Faces of all tiles
+    Vector3 light;              // Light position (or direction) of the last bake
+    bool directional;
+    bool baked;                 // False until the first bake and after geometry changes
+} LightBake;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+LightBake LoadLightBake(const HeightMap *map);              // Build the faces and upload the mesh, nothing baked yet
+void UnloadLightBake(LightBake *bake);
+void UpdateLightBakeGeometry(LightBake *bake, const HeightMap *map);     // Rebuild every face, the next BakeLight traces them all
+void UpdateLightBakeColumn(LightBake *bake, const HeightMap *map, int x, int z);    // Rebuild around column (x, z) and retrace what it can shadow, call after changing it
+bool BakeLight(LightBake *bake, const HeightMap *map, Vector3 light, bool directional);  // Trace the faces unless already baked for this light, true when it traced
+void DrawLightBake(const LightBake *bake, Material material);                  // Draw every tile's mesh
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LIGHTBAKE_H
+
+/***********************************************************************************
+*
+*   LIGHTBAKE IMPLEMENTATION
+*
+************************************************************************************/
+
+#if defined(LIGHTBAKE_IMPLEMENTATION) && !defined(LIGHTBAKE_IMPLEMENTED)
+#define LIGHTBAKE_IMPLEMENTED
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "jobs.h"
+#include "raymath.h"
+
+// Outward normal and two edges of every side with cross(u, v) == normal, so the quads wind
+// counter clockwise seen from outside
+static const Vector3 lightBakeNormals[5] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+static const Vector3 lightBakeU[5] = { { 0, 1, 0 }, { 0, 0, 1 }, { 0, 0, 1 }, { 1, 0, 0 }, { 0, 1, 0 } };
+static const Vector3 lightBakeV[5] = { { 0, 0, 1 }, { 0, 1, 0 }, { 1, 0, 0 }, { 0, 1, 0 }, { 1, 0, 0 } };
+
+// Face f of tile t
+typedef struct LightBakeTask {
+    int tile;
+    int face;
+} LightBakeTask;
+
+typedef struct LightBakeJob {
+    LightBake *bake;
+    const HeightMap *map;
+    const LightBakeTask *tasks;     // Faces to trace, NULL for every face of the tiles in the range
+    Vector3 light;
+    bool directional;
+    float far;                  // Distance along a directional light that clears the whole map
+} LightBakeJob;
+
+static Vector3 LightBakeAxpy(Vector3 p, Vector3 d, float s)
+{
+    return (Vector3){ p.x + d.x*s, p.y + d.y*s, p.z + d.z*s };
+}
+
+static Vector3 LightBakeFaceCenter(BakedFace face)
+{
+    Vector3 center = { face.x + 0.5f, face.y - 0.5f, face.z + 0.5f };
+    return LightBakeAxpy(center, lightBakeNormals[face.side], 0.5f);
+}
+
+static Color LightBakeColor(float visibility)
+{
+    return (Color){
+        (unsigned char)(LIGHTBAKE_SHADOWED.r + (LIGHTBAKE_LIT.r - LIGHTBAKE_SHADOWED.r)*visibility),
+        (unsigned char)(LIGHTBAKE_SHADOWED.g + (LIGHTBAKE_LIT.g - LIGHTBAKE_SHADOWED.g)*visibility),
+        (unsigned char)(LIGHTBAKE_SHADOWED.b + (LIGHTBAKE_LIT.b - LIGHTBAKE_SHADOWED.b)*visibility),
+        255
+    };
+}
+
+// Faces of column (x, z): its top and the part of each wall above the neighbour. Only
+// counts them when faces is NULL
+static int LightBakeColumnFaces(const HeightMap *map, int x, int z, BakedFace *faces)
+{
+    static const int dx[4] = { 1, -1, 0, 0 };
+    static const int dz[4] = { 0, 0, 1, -1 };
+    static const int sides[4] = { 0, 1, 3, 4 };
+
+    int h = GetHeight(map, x, z);
+    if (h <= 0) return 0;
+
+    int count = 0;
+    if (faces) faces[count] = (BakedFace){ (short)x, (short)(h - 1), (short)z, 2 };
+    count++;
+
+    for (int i = 0; i < 4; i++)
+    {
+        int neighbour = GetHeight(map, x + dx[i], z + dz[i]);
+        for (int y = (neighbour > 0 ? neighbour : 0); y < h; y++)
+        {
+            if (faces) faces[count] = (BakedFace){ (short)x, (short)y, (short)z, (short)sides[i] };
+            count++;
+        }
+    }
+
+    return count;
+}
+
+static void LightBakeTileColumns(const LightBake *bake, int t, int *x0, int *z0, int *x1, int *z1)
+{
+    *x0 = (t % bake->tilesPerSide)*LIGHTBAKE_TILE_SIZE;
+    *z0 = (t / bake->tilesPerSide)*LIGHTBAKE_TILE_SIZE;
+    *x1 = (*x0 + LIGHTBAKE_TILE_SIZE < bake->size) ? *x0 + LIGHTBAKE_TILE_SIZE : bake->size;
+    *z1 = (*z0 + LIGHTBAKE_TILE_SIZE < bake->size) ? *z0 + LIGHTBAKE_TILE_SIZE : bake->size;
+}
+
+// Squared xz distance from (cx, cz) to the path from (ax, az) to the light of the bake
+static float LightBakePathDistance2(const LightBake *bake, float ax, float az, float cx, float cz)
+{
+    float ux = bake->directional ? bake->light.x : bake->light.x - ax;
+    float uz = bake->directional ? bake->light.z : bake->light.z - az;
+    float wx = cx - ax, wz = cz - az;
+    float length = ux*ux + uz*uz;
+    float u = (length > 0) ? fmaxf((wx*ux + wz*uz)/length, 0.0f) : 0.0f;
+    if (!bake->directional && u > 1) u = 1;
+    float ex = wx - u*ux, ez = wz - u*uz;
+    return ex*ex + ez*ez;
+}
+
+// Vertex colors from the visibility of every face
+static void LightBakeTileColors(LightBakeTile *tile)
+{
+    for (int f = 0; f < tile->faceCount; f++)
+    {
+        Color c = LightBakeColor(tile->visibility[f]);
+        for (int i = 0; i < 6; i++)
+        {
+            ((Color *)tile->mesh.colors)[f*6 + i] = c;
+        }
+    }
+}
+
+static void LightBakeBuildMesh(LightBakeTile *tile)
+{
+    if (tile->mesh.vertexCount > 0) UnloadMesh(tile->mesh);
+    tile->mesh = (Mesh){ 0 };
+
+    // Empty tiles get no buffers at all, everything frees them only when there are vertices
+    if (tile->faceCount == 0) return;
+
+    Mesh mesh = { 0 };
+    mesh.vertexCount = tile->faceCount*6;
+    mesh.triangleCount = tile->faceCount*2;
+    mesh.vertices = (float *)RL_MALLOC(mesh.vertexCount*3*sizeof(float));
+    mesh.normals = (float *)RL_MALLOC(mesh.vertexCount*3*sizeof(float));
+    mesh.colors = (unsigned char *)RL_MALLOC(mesh.vertexCount*4*sizeof(unsigned char));
+
+    static const float corners[6][2] = { { -0.5f, -0.5f }, { 0.5f, -0.5f }, { 0.5f, 0.5f }, { -0.5f, -0.5f }, { 0.5f, 0.5f }, { -0.5f, 0.5f } };
+
+    for (int f = 0; f < tile->faceCount; f++)
+    {
+        BakedFace face = tile->faces[f];
+        Vector3 center = LightBakeFaceCenter(face);
+        Vector3 n = lightBakeNormals[face.side];
+
+        for (int i = 0; i < 6; i++)
+        {
+            Vector3 p = LightBakeAxpy(LightBakeAxpy(center, lightBakeU[face.side], corners[i][0]), lightBakeV[face.side], corners[i][1]);
+            int v = f*6 + i;
+            mesh.vertices[v*3 + 0] = p.x;
+            mesh.vertices[v*3 + 1] = p.y;
+            mesh.vertices[v*3 + 2] = p.z;
+            mesh.normals[v*3 + 0] = n.x;
+            mesh.normals[v*3 + 1] = n.y;
+            mesh.normals[v*3 + 2] = n.z;
+        }
+    }
+    tile->mesh = mesh;
+    LightBakeTileColors(tile);
+
+    // Dynamic, the colors get rewritten on every bake
+    UploadMesh(&tile->mesh, true);
+}
+
+// Regenerate the faces of a tile. With edit set only columns within one step of (x, z)
+// are regenerated, the others keep their faces and visibility
+static void LightBakeBuildTile(LightBake *bake, const HeightMap *map, int t, bool edit, int x, int z)
+{
+    LightBakeTile *tile = &bake->tiles[t];
+    int x0, z0, x1, z1;
+    LightBakeTileColumns(bake, t, &x0, &z0, &x1, &z1);
+
+    int count = 0;
+    for (int f = 0; edit && f < tile->faceCount; f++)
+    {
+        if (abs(tile->faces[f].x - x) + abs(tile->faces[f].z - z) > 1) count++;
+    }
+    for (int cz = z0; cz < z1; cz++)
+    {
+        for (int cx = x0; cx < x1; cx++)
+        {
+            if (!edit || abs(cx - x) + abs(cz - z) <= 1) count += LightBakeColumnFaces(map, cx, cz, NULL);
+        }
+    }
+
+    BakedFace *faces = (BakedFace *)RL_MALLOC(count*sizeof(BakedFace));
+    float *visibility = (float *)RL_CALLOC(count, sizeof(float));
+
+    // Old faces come column by column in the same order, so one pass merges them
+    int k = 0, j = 0;
+    for (int cz = z0; cz < z1; cz++)
+    {
+        for (int cx = x0; cx < x1; cx++)
+        {
+            int start = j;
+            while (j < tile->faceCount && tile->faces[j].x == cx && tile->faces[j].z == cz) j++;
+
+            if (!edit || abs(cx - x) + abs(cz - z) <= 1) k += LightBakeColumnFaces(map, cx, cz, faces + k);
+            else
+            {
+                memcpy(faces + k, tile->faces + start, (j - start)*sizeof(BakedFace));
+                memcpy(visibility + k, tile->visibility + start, (j - start)*sizeof(float));
+                k += j - start;
+            }
+        }
+    }
+
+    bake->faceCount += count - tile->faceCount;
+    RL_FREE(tile->faces);
+    RL_FREE(tile->visibility);
+    tile->faceCount = count;
+    tile->faces = faces;
+    tile->visibility = visibility;
+}
+
+// Lit fraction of 2x2 samples of a face, nudged into its own voxel so the walk starts from
+// the column the face belongs to
+static float LightBakeFaceVisibility(const LightBakeJob *job, BakedFace face)
+{
+    Vector3 n = lightBakeNormals[face.side];
+    Vector3 center = LightBakeAxpy(LightBakeFaceCenter(face), n, -1e-3f);
+    int lit = 0;
+
+    for (int s = 0; s < 4; s++)
+    {
+        Vector3 from = LightBakeAxpy(LightBakeAxpy(center, lightBakeU[face.side], (s & 1) ? 0.25f : -0.25f),
+            lightBakeV[face.side], (s & 2) ? 0.25f : -0.25f);
+        Vector3 to = job->directional ? LightBakeAxpy(from, job->light, job->far) : job->light;
+
+        float facing = (to.x - from.x)*n.x + (to.y - from.y)*n.y + (to.z - from.z)*n.z;
+        if (facing > 0 && !TraceHeightMapShadow(job->map, from, to, NULL, 0, NULL)) lit++;
+    }
+
+    return lit/4.0f;
+}
+
+// A range of tiles, or of tasks when the job has them
+static void LightBakeJobRun(void *data, int begin, int end)
+{
+    LightBakeJob *job = (LightBakeJob *)data;
+
+    for (int k = begin; k < end; k++)
+    {
+        if (job->tasks)
+        {
+            LightBakeTile *tile = &job->bake->tiles[job->tasks[k].tile];
+            int f = job->tasks[k].face;
+            tile->visibility[f] = LightBakeFaceVisibility(job, tile->faces[f]);
+            continue;
+        }
+
+        LightBakeTile *tile = &job->bake->tiles[k];
+        for (int f = 0; f < tile->faceCount; f++)
+        {
+            tile->visibility[f] = LightBakeFaceVisibility(job, tile->faces[f]);
+        }
+    }
+}
+
+// Trace the tasks, or every face when tasks is NULL
+static void LightBakeTrace(LightBake *bake, const HeightMap *map, const LightBakeTask *tasks, int count, Vector3 light, bool directional)
+{
+    int maxHeight = GetHeightMapMax(map, map->mipLevels, 0, 0);
+    LightBakeJob job = { bake, map, tasks, light, directional, 2.0f*(map->size + maxHeight) };
+    JobGroup group = { 0 };
+    if (tasks) DispatchJobs(&group, LightBakeJobRun, &job, count, 64);
+    else DispatchJobs(&group, LightBakeJobRun, &job, bake->tilesPerSide*bake->tilesPerSide, 1);
+    WaitJobGroup(&group);
+}
+
+LightBake LoadLightBake(const HeightMap *map)
+{
+    LightBake bake = { 0 };
+    UpdateLightBakeGeometry(&bake, map);
+    return bake;
+}
+
+void UnloadLightBake(LightBake *bake)
+{
+    for (int t = 0; t < bake->tilesPerSide*bake->tilesPerSide; t++)
+    {
+        LightBakeTile *tile = &bake->tiles[t];
+        if (tile->mesh.vertexCount > 0) UnloadMesh(tile->mesh);
+        RL_FREE(tile->faces);
+        RL_FREE(tile->visibility);
+    }
+    RL_FREE(bake->tiles);
+    *bake = (LightBake){ 0 };
+}
+
+void UpdateLightBakeGeometry(LightBake *bake, const HeightMap *map)
+{
+    UnloadLightBake(bake);
+
+    bake->size = map->size;
+    bake->tilesPerSide = (map->size + LIGHTBAKE_TILE_SIZE - 1)/LIGHTBAKE_TILE_SIZE;
+    bake->tiles = (LightBakeTile *)RL_CALLOC(bake->tilesPerSide*bake->tilesPerSide, sizeof(LightBakeTile));
+
+    for (int t = 0; t < bake->tilesPerSide*bake->tilesPerSide; t++)
+    {
+        LightBakeBuildTile(bake, map, t, false, 0, 0);
+        LightBakeBuildMesh(&bake->tiles[t]);
+    }
+}
+
+void UpdateLightBakeColumn(LightBake *bake, const HeightMap *map, int x, int z)
+{
+    if (x < 0 || z < 0 || x >= bake->size || z >= bake->size) return;
+
+    // Height the column had when its faces were built, from its top face
+    int tileCount = bake->tilesPerSide*bake->tilesPerSide;
+    int top = GetHeight(map, x, z);
+    const LightBakeTile *home = &bake->tiles[(z/LIGHTBAKE_TILE_SIZE)*bake->tilesPerSide + x/LIGHTBAKE_TILE_SIZE];
+    for (int f = 0; f < home->faceCount; f++)
+    {
+        BakedFace face = home->faces[f];
+        if (face.x == x && face.z == z && face.side == 2 && face.y + 1 > top) top = face.y + 1;
+    }
+
+    // The column and its neighbours span at most three tiles
+    unsigned char *touched = (unsigned char *)RL_CALLOC(tileCount, 1);
+    static const int dx[5] = { 0, 1, -1, 0, 0 };
+    static const int dz[5] = { 0, 0, 0, 1, -1 };
+    for (int i = 0; i < 5; i++)
+    {
+        int cx = x + dx[i], cz = z + dz[i];
+        if (cx < 0 || cz < 0 || cx >= bake->size || cz >= bake->size) continue;
+
+        int t = (cz/LIGHTBAKE_TILE_SIZE)*bake->tilesPerSide + cx/LIGHTBAKE_TILE_SIZE;
+        if (!touched[t]) LightBakeBuildTile(bake, map, t, true, x, z);
+        touched[t] = 1;
+    }
+
+    // Until the first bake there is no light to retrace for
+    LightBakeTask *tasks = NULL;
+    int count = 0;
+    if (bake->baked)
+    {
+        // A face needs a new trace when one of its sample rays passes over the column below
+        // the taller of its old and new heights. Over the column the xz path of the face
+        // centre comes within its half diagonal plus the sample spread (0.25*sqrt(2)) of the
+        // column centre, and the samples sit at most 0.25 below the face centre
+        float margin = 1.07f;
+        float cx = x + 0.5f, cz = z + 0.5f;
+        tasks = (LightBakeTask *)RL_MALLOC(bake->faceCount*sizeof(LightBakeTask));
+
+        for (int t = 0; t < tileCount; t++)
+        {
+            // The paths of a tile's faces stay within its half diagonal of the path from its
+            // centre, tiles that path keeps clear of the column are skipped whole
+            int x0, z0, x1, z1;
+            LightBakeTileColumns(bake, t, &x0, &z0, &x1, &z1);
+            float radius = 0.5f*sqrtf((float)((x1 - x0)*(x1 - x0) + (z1 - z0)*(z1 - z0))) + margin;
+            if (!(touched[t] & 1) && LightBakePathDistance2(bake, 0.5f*(x0 + x1), 0.5f*(z0 + z1), cx, cz) > radius*radius) continue;
+
+            LightBakeTile *tile = &bake->tiles[t];
+            for (int f = 0; f < tile->faceCount; f++)
+            {
+                BakedFace face = tile->faces[f];
+                Vector3 a = LightBakeFaceCenter(face);
+                float base = a.y - 0.26f;
+
+                // Path a + u*(ux, rise, uz): u up to 1 towards a point light, unbounded for the sun
+                float ux = bake->directional ? bake->light.x : bake->light.x - a.x;
+                float uz = bake->directional ? bake->light.z : bake->light.z - a.z;
+                float rise = bake->directional ? bake->light.y : bake->light.y - base;
+                float wx = cx - a.x, wz = cz - a.z;
+                float length = ux*ux + uz*uz;
+
+                bool crosses = false;
+                if (length == 0) crosses = (wx*wx + wz*wz <= margin*margin);
+                else
+                {
+                    // Span of u where the path is within margin of the column centre
+                    float u0 = (wx*ux + wz*uz)/length;
+                    float ex = wx - u0*ux, ez = wz - u0*uz;
+                    float e2 = ex*ex + ez*ez;
+                    if (e2 <= margin*margin)
+                    {
+                        float d = sqrtf((margin*margin - e2)/length);
+                        float lo = fmaxf(u0 - d, 0.0f);
+                        float hi = bake->directional ? u0 + d : fminf(u0 + d, 1.0f);
+                        crosses = (lo <= hi) && (base + ((rise >= 0) ? lo : hi)*rise <= (float)top);
+                    }
+                }
+
+                bool rebuilt = abs(face.x - x) + abs(face.z - z) <= 1;
+                if (crosses || rebuilt)
+                {
+                    tasks[count++] = (LightBakeTask){ t, f };
+                    touched[t] |= 2;
+                }
+            }
+        }
+
+        LightBakeTrace(bake, map, tasks, count, bake->light, bake->directional);
+    }
+
+    // Rebuilt tiles get new meshes, the others only new colors
+    for (int t = 0; t < tileCount; t++)
+    {
+        LightBakeTile *tile = &bake->tiles[t];
+        if (touched[t] & 1) LightBakeBuildMesh(tile);
+        else if (touched[t] & 2)
+        {
+            LightBakeTileColors(tile);
+            UpdateMeshBuffer(tile->mesh, 3, tile->mesh.colors, tile->mesh.vertexCount*4, 0);
+        }
+    }
+
+    RL_FREE(tasks);
+    RL_FREE(touched);
+}
+
+bool BakeLight(LightBake *bake, const HeightMap *map, Vector3 light, bool directional)
+{
+    if (bake->baked && bake->directional == directional &&
+        bake->light.x == light.x && bake->light.y == light.y && bake->light.z == light.z)
+    {
+        return false;
+    }
+
+    LightBakeTrace(bake, map, NULL, 0, light, directional);
+
+    for (int t = 0; t < bake->tilesPerSide*bake->tilesPerSide; t++)
+    {
+        LightBakeTile *tile = &bake->tiles[t];
+        if (tile->mesh.vertexCount == 0) continue;
+        LightBakeTileColors(tile);
+        UpdateMeshBuffer(tile->mesh, 3, tile->mesh.colors, tile->mesh.vertexCount*4, 0);
+    }
+
+    bake->light = light;
+    bake->directional = directional;
+    bake->baked = true;
+    return true;
+}
+
+void DrawLightBake(const LightBake *bake, Material material)
+{
+    for (int t = 0; t < bake->tilesPerSide*bake->tilesPerSide; t++)
+    {
+        if (bake->tiles[t].mesh.vertexCount > 0) DrawMesh(bake->tiles[t].mesh, material, MatrixIdentity());
+    }
+}
+
+#endif // LIGHTBAKE_IMPLEMENTATION
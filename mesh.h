@@ -0,0 +1,1367 @@
+/**********************************************************************************************
+*
+*   mesh - Mesh loading: Lua mesh scripts and the binary mesh format
+*
+*   Lua meshes are scripts defining flat 'vertices' (xyz) and 'colors' (rgba) arrays
+*   describing a non-indexed triangle list, see mesh/cube.lua. All scripts run in one
+*   shared interpreter, see ReadLuaMesh.
+*
+*   WeldMesh turns such a soup into an indexed mesh by merging vertices whose position,
+*   normal and color match exactly, OptimizeMeshVertexCache then orders the triangles
+*   for the GPU post-transform cache (Forsyth) and the vertices by first use.
+*
+*   CalcMeshNormalsEx and CalcMeshTangents work on blocks of 8 triangles with GCC vector
+*   extensions (an AVX2 and an SSE2 build picked at runtime, like dda.h) and accumulate the
+*   per triangle results into vertices afterwards.
+*
+*   Geometry on a lattice (voxels, greedy terrain) can be uploaded as 8 byte PackedVertex
+*   instead of 28 bytes of float position, float normal and RGBA8 color. Positions are
+*   int16 multiples of a scale, the normal is one of six faces and the color indexes a
+*   MeshPalette. Draw such meshes with vertpacked.glsl and SetShaderPalette.
+*
+*   The binary format is what meshconv writes from those scripts. A fixed header is
+*   followed by the vertex streams, each starting on a MESH_FILE_ALIGN boundary, so the
+*   file can be mapped into memory and the Mesh pointed straight at it with no parsing:
+*
+*       MeshFileHeader
+*       positions   float[vertexCount*3]
+*       normals     float[vertexCount*3]
+*       colors      unsigned char[vertexCount*4]
+*       indices     unsigned short[indexCount]     (empty for triangle soups)
+*
+*   All values are little endian. 'hash' is FNV-1a 64 over every byte after the header.
+*   LoadMeshBinary checks every stream against the counts in the header and every index
+*   against vertexCount, so no file can point the mesh outside the mapping. It leaves the
+*   hash alone: that reads every byte of a mapping meant to be paged in as it gets used,
+*   call VerifyMeshBinary when corruption (rather than a bad layout) matters.
+*
+*   CONFIGURATION:
+*
+*   #define MESH_IMPLEMENTATION
+*       Generates the implementation of the library into the included file.
+*       Only ONE file should hold the implementation.
+*
+**********************************************************************************************/
+
+#ifndef MESH_H
+#define MESH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "raylib.h"
+
+#include "lua.h"
+#include "lualib.h"
+#include "lauxlib.h"
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define MESH_FILE_MAGIC     0x48534d47      // "GMSH"
+#define MESH_FILE_VERSION   1
+#define MESH_FILE_ALIGN     16
+
+#define MESH_CACHE_SIZE     32              // Post-transform cache entries OptimizeMeshVertexCache targets
+
+#define MESH_PALETTE_SIZE   64              // Colors packed meshes can use, matches vertpacked.glsl
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef enum {
+    MESH_STREAM_POSITIONS = 0,
+    MESH_STREAM_NORMALS,
+    MESH_STREAM_COLORS,
+    MESH_STREAM_INDICES,
+    MESH_STREAM_COUNT
+} MeshStream;
+
+typedef struct MeshFileStream {
+    uint64_t offset;                // Bytes from the start of the file
+    uint64_t size;                  // Bytes, 0 when the stream is absent
+} MeshFileStream;
+
+typedef struct MeshFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertexCount;
+    uint32_t triangleCount;
+    uint32_t indexCount;
+    uint32_t reserved;
+    uint64_t hash;
+    MeshFileStream streams[MESH_STREAM_COUNT];
+} MeshFileHeader;
+
+// LoadLuaMeshEx options
+typedef enum {
+    MESH_LOAD_WELD = 1,             // Merge identical vertices and build an index buffer
+    MESH_LOAD_OPTIMIZE = 2,         // Reorder indexed triangles for the vertex cache
+    MESH_LOAD_SMOOTH = 4,           // Angle weighted smooth normals instead of flat ones
+    MESH_LOAD_TANGENTS = 8,         // Also generate tangents
+} MeshLoadFlags;
+
+typedef enum {
+    MESH_NORMALS_FLAT = 0,          // One normal per triangle, needs a non-indexed mesh
+    MESH_NORMALS_SMOOTH,            // Angle weighted average over the triangles sharing a vertex (a position when unindexed)
+} MeshNormalMode;
+
+// Backing memory of a mesh loaded from a binary file
+typedef struct MeshFile {
+    void *data;
+    size_t size;
+    bool mapped;                    // Memory mapped, otherwise a heap copy
+} MeshFile;
+
+// 8 byte vertex for lattice aligned geometry, decoded by vertpacked.glsl
+typedef struct PackedVertex {
+    short position[3];              // Position divided by the mesh position scale
+    unsigned char face;             // Axis aligned normal: +X, -X, +Y, -Y, +Z, -Z
+    unsigned char color;            // Index into the MeshPalette
+} PackedVertex;
+
+// Colors shared by every packed mesh drawn with one shader
+typedef struct MeshPalette {
+    int count;
+    Color colors[MESH_PALETTE_SIZE];
+} MeshPalette;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+void DumpLuaStack(lua_State *L);
+void CalcMeshNormals(Mesh *mesh);                                   // Flat normal per triangle
+void CalcMeshNormalsEx(Mesh *mesh, MeshNormalMode mode);            // Flat, or smooth over all corners sharing a position
+void CalcMeshTangents(Mesh *mesh);                                  // xyz tangent and w handedness from normals and texcoords
+bool ReadLuaMesh(Mesh *mesh, const char *filename);                 // Run a mesh script into CPU side arrays
+void LoadLuaMesh(Mesh *mesh, const char *filename);                 // Read, calculate normals and upload
+void LoadLuaMeshEx(Mesh *mesh, const char *filename, int flags);    // LoadLuaMesh with MeshLoadFlags
+void UnloadLuaMeshVM(void);                                         // Close the interpreter shared by mesh loads
+
+uint64_t MeshFileHash(const void *data, size_t size);
+bool ExportMeshBinary(Mesh mesh, const char *fileName);             // Write the binary mesh format
+Mesh LoadMeshBinary(const char *fileName, MeshFile *file);          // Map a binary mesh, vertexCount is 0 on failure
+bool VerifyMeshBinary(const MeshFile *file);                        // Check the content hash
+void UnloadMeshBinary(MeshFile *file, Mesh *mesh);                  // Unmap, clearing mesh pointers into the file
+
+bool WeldMesh(Mesh *mesh);                                          // Index a triangle soup, merging identical vertices
+void OptimizeMeshVertexCache(Mesh *mesh);                           // Reorder triangles then vertices for cache hits
+float GetMeshACMR(Mesh mesh, int cacheSize);                        // Vertex shader runs per triangle with a FIFO cache
+
+bool PackMesh(Mesh mesh, float positionScale, MeshPalette *palette, PackedVertex *packed);  // False if a vertex doesn't fit
+bool UploadMeshPacked(Mesh *mesh, float positionScale, MeshPalette *palette);   // Upload as PackedVertex, frees float arrays
+void SetShaderPalette(Shader shader, const MeshPalette *palette, float positionScale);   // Uniforms vertpacked.glsl decodes with
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MESH_H
+
+/***********************************************************************************
+*
+*   MESH IMPLEMENTATION
+*
+************************************************************************************/
+
+#if defined(MESH_IMPLEMENTATION) && !defined(MESH_IMPLEMENTED)
+#define MESH_IMPLEMENTED
+
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "raymath.h"
+#include "rlgl.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+void DumpLuaStack(lua_State *L)
+{
+    printf("STACK\n");
+    int top = lua_gettop(L);
+    for (int i = 1; i <= top; i++)
+    {
+        printf("%d\t%s\t", i, luaL_typename(L, i));
+        switch (lua_type(L, i))
+        {
+        case LUA_TNUMBER:
+            printf("%g\n", lua_tonumber(L, i));
+            break;
+        case LUA_TSTRING:
+            printf("%s\n", lua_tostring(L, i));
+            break;
+        case LUA_TBOOLEAN:
+            printf("%s\n", (lua_toboolean(L, i) ? "true" : "false"));
+            break;
+        case LUA_TNIL:
+            printf("%s\n", "nil");
+            break;
+        default:
+            printf("%p\n", lua_topointer(L, i));
+            break;
+        }
+    }
+}
+
+static int MeshGroupVertices(const Mesh *mesh, bool positionOnly, int *remap, int *unique);
+
+void CalcMeshNormals(Mesh *mesh)
+{
+    CalcMeshNormalsEx(mesh, MESH_NORMALS_FLAT);
+}
+
+//----------------------------------------------------------------------------------
+// Normals and tangents
+//----------------------------------------------------------------------------------
+
+// Per triangle results of the vectorized pass, accumulated into vertices afterwards
+typedef struct MeshTriangleFrames {
+    float *normals;         // Unit face normal, xyz per triangle
+    float *angles;          // Interior angle per corner
+    float *tangents;        // Direction of increasing u, xyz per triangle, NULL to skip
+    float *bitangents;      // Direction of increasing v
+} MeshTriangleFrames;
+
+static inline int MeshCorner(const Mesh *mesh, int corner)
+{
+    return mesh->indices ? mesh->indices[corner] : corner;
+}
+
+static inline int MeshTriangleCount(const Mesh *mesh)
+{
+    return mesh->indices ? mesh->triangleCount : mesh->vertexCount / 3;
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+#define MESH_LANES 8
+
+typedef float mv8f __attribute__((vector_size(32)));
+typedef int mv8i __attribute__((vector_size(32)));
+
+#define MESH_SELECTF(mask, a, b) ((mv8f)(((mask) & (mv8i)(a)) | (~(mask) & (mv8i)(b))))
+
+// 1/sqrt(x) from the bit trick plus two Newton steps, about 5e-6 relative error
+static inline __attribute__((always_inline)) void MeshRsqrt(const mv8f *x, mv8f *out)
+{
+    mv8f y = (mv8f)(0x5f375a86 - ((mv8i)*x >> 1));
+    y = y * (1.5f - 0.5f * *x * y * y);
+    *out = y * (1.5f - 0.5f * *x * y * y);
+}
+
+// acos with the Abramowitz and Stegun 4.4.45 polynomial, under 1e-4 radians of error
+static inline __attribute__((always_inline)) void MeshAcos(const mv8f *x, mv8f *out)
+{
+    mv8i negative = *x < 0;
+    mv8f a = MESH_SELECTF(negative, -*x, *x);
+    mv8f s = 1.0f - a;
+    mv8f r;
+    MeshRsqrt(&s, &r);
+    mv8f poly = 1.5707288f + a * (-0.2121144f + a * (0.0742610f + a * -0.0187293f));
+    mv8f angle = MESH_SELECTF(s > 0, s * r, (mv8f){0}) * poly;
+    *out = MESH_SELECTF(negative, PI - angle, angle);
+}
+
+// Angle between edges a and b given their dot product and squared lengths
+static inline __attribute__((always_inline)) void MeshCornerAngle(const mv8f *dot, const mv8f *lengths, mv8f *out)
+{
+    mv8f r, c;
+    mv8f l = MESH_SELECTF(*lengths > 1e-30f, *lengths, (mv8f){0} + 1.0f);
+    MeshRsqrt(&l, &r);
+    c = *dot * r;
+    c = MESH_SELECTF(c > 1.0f, (mv8f){0} + 1.0f, c);
+    c = MESH_SELECTF(c < -1.0f, (mv8f){0} - 1.0f, c);
+    MeshAcos(&c, out);
+}
+
+// Frames of up to 8 triangles starting at triangle base. Compiled once per instruction
+// set by the wrappers below.
+static inline __attribute__((always_inline)) void MeshTriangleBlock(const Mesh *mesh, int base, int lanes, MeshTriangleFrames *frames)
+{
+    mv8f p[3][3] = {0}, uv[3][2] = {0};
+    bool texcoords = frames->tangents && mesh->texcoords;
+
+    for (int l = 0; l < lanes; l++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            int v = MeshCorner(mesh, (base + l)*3 + k);
+            p[k][0][l] = mesh->vertices[v*3 + 0];
+            p[k][1][l] = mesh->vertices[v*3 + 1];
+            p[k][2][l] = mesh->vertices[v*3 + 2];
+            if (texcoords)
+            {
+                uv[k][0][l] = mesh->texcoords[v*2 + 0];
+                uv[k][1][l] = mesh->texcoords[v*2 + 1];
+            }
+        }
+    }
+
+    mv8f e1[3], e2[3], e3[3];
+    for (int a = 0; a < 3; a++)
+    {
+        e1[a] = p[1][a] - p[0][a];
+        e2[a] = p[2][a] - p[0][a];
+        e3[a] = p[2][a] - p[1][a];
+    }
+
+    mv8f n[3] = {
+        e1[1]*e2[2] - e1[2]*e2[1],
+        e1[2]*e2[0] - e1[0]*e2[2],
+        e1[0]*e2[1] - e1[1]*e2[0],
+    };
+    mv8f n2 = n[0]*n[0] + n[1]*n[1] + n[2]*n[2];
+    mv8i valid = n2 > 1e-30f;
+    mv8f inv;
+    MeshRsqrt(&n2, &inv);
+    inv = MESH_SELECTF(valid, inv, (mv8f){0});
+
+    mv8f angle[3] = {0};
+    if (frames->angles)
+    {
+        mv8f l1 = e1[0]*e1[0] + e1[1]*e1[1] + e1[2]*e1[2];
+        mv8f l2 = e2[0]*e2[0] + e2[1]*e2[1] + e2[2]*e2[2];
+        mv8f l3 = e3[0]*e3[0] + e3[1]*e3[1] + e3[2]*e3[2];
+        mv8f d0 = e1[0]*e2[0] + e1[1]*e2[1] + e1[2]*e2[2];
+        mv8f d1 = -(e1[0]*e3[0] + e1[1]*e3[1] + e1[2]*e3[2]);
+        mv8f lengths0 = l1*l2, lengths1 = l1*l3;
+        MeshCornerAngle(&d0, &lengths0, &angle[0]);
+        MeshCornerAngle(&d1, &lengths1, &angle[1]);
+        angle[2] = PI - angle[0] - angle[1];
+        angle[2] = MESH_SELECTF(angle[2] < 0, (mv8f){0}, angle[2]);
+    }
+
+    mv8f t[3] = {0}, b[3] = {0};
+    if (texcoords)
+    {
+        mv8f du1 = uv[1][0] - uv[0][0], dv1 = uv[1][1] - uv[0][1];
+        mv8f du2 = uv[2][0] - uv[0][0], dv2 = uv[2][1] - uv[0][1];
+        mv8f r = du1*dv2 - du2*dv1;
+        mv8i solvable = (r > 1e-20f) | (r < -1e-20f);
+        r = MESH_SELECTF(solvable, 1.0f / MESH_SELECTF(solvable, r, (mv8f){0} + 1.0f), (mv8f){0});
+        for (int a = 0; a < 3; a++)
+        {
+            t[a] = (e1[a]*dv2 - e2[a]*dv1) * r;
+            b[a] = (e2[a]*du1 - e1[a]*du2) * r;
+        }
+    }
+
+    for (int l = 0; l < lanes; l++)
+    {
+        int i = base + l;
+        for (int a = 0; a < 3; a++)
+        {
+            frames->normals[i*3 + a] = n[a][l] * inv[l];
+        }
+        if (frames->angles)
+        {
+            for (int a = 0; a < 3; a++)
+            {
+                frames->angles[i*3 + a] = angle[a][l];
+            }
+        }
+        if (frames->tangents)
+        {
+            for (int a = 0; a < 3; a++)
+            {
+                frames->tangents[i*3 + a] = t[a][l];
+                frames->bitangents[i*3 + a] = b[a][l];
+            }
+        }
+    }
+}
+
+__attribute__((target("avx2"))) static void MeshTriangleFramesAVX2(const Mesh *mesh, int count, MeshTriangleFrames *frames)
+{
+    for (int i = 0; i < count; i += MESH_LANES)
+    {
+        MeshTriangleBlock(mesh, i, (count - i < MESH_LANES) ? count - i : MESH_LANES, frames);
+    }
+}
+
+static void MeshTriangleFramesSSE(const Mesh *mesh, int count, MeshTriangleFrames *frames)
+{
+    for (int i = 0; i < count; i += MESH_LANES)
+    {
+        MeshTriangleBlock(mesh, i, (count - i < MESH_LANES) ? count - i : MESH_LANES, frames);
+    }
+}
+
+static void MeshCalcTriangleFrames(const Mesh *mesh, MeshTriangleFrames *frames)
+{
+    if (__builtin_cpu_supports("avx2")) MeshTriangleFramesAVX2(mesh, MeshTriangleCount(mesh), frames);
+    else MeshTriangleFramesSSE(mesh, MeshTriangleCount(mesh), frames);
+}
+
+#else
+
+static float MeshCornerAngle(Vector3 a, Vector3 b)
+{
+    float lengths = Vector3LengthSqr(a) * Vector3LengthSqr(b);
+    if (lengths <= 1e-30f) return PI/2;
+    return acosf(Clamp(Vector3DotProduct(a, b) / sqrtf(lengths), -1.0f, 1.0f));
+}
+
+static void MeshCalcTriangleFrames(const Mesh *mesh, MeshTriangleFrames *frames)
+{
+    bool texcoords = frames->tangents && mesh->texcoords;
+
+    for (int i = 0; i < MeshTriangleCount(mesh); i++)
+    {
+        int v[3];
+        Vector3 p[3];
+        for (int k = 0; k < 3; k++)
+        {
+            v[k] = MeshCorner(mesh, i*3 + k);
+            p[k] = (Vector3){ mesh->vertices[v[k]*3], mesh->vertices[v[k]*3 + 1], mesh->vertices[v[k]*3 + 2] };
+        }
+
+        Vector3 e1 = Vector3Subtract(p[1], p[0]);
+        Vector3 e2 = Vector3Subtract(p[2], p[0]);
+        Vector3 e3 = Vector3Subtract(p[2], p[1]);
+        Vector3 normal = Vector3Normalize(Vector3CrossProduct(e1, e2));
+
+        memcpy(&frames->normals[i*3], &normal, sizeof(normal));
+        if (frames->angles)
+        {
+            float angle0 = MeshCornerAngle(e1, e2);
+            float angle1 = MeshCornerAngle(Vector3Negate(e1), e3);
+            frames->angles[i*3 + 0] = angle0;
+            frames->angles[i*3 + 1] = angle1;
+            frames->angles[i*3 + 2] = fmaxf(PI - angle0 - angle1, 0.0f);
+        }
+
+        if (frames->tangents)
+        {
+            Vector3 t = { 0 }, b = { 0 };
+            if (texcoords)
+            {
+                const float *uv = mesh->texcoords;
+                float du1 = uv[v[1]*2] - uv[v[0]*2], dv1 = uv[v[1]*2 + 1] - uv[v[0]*2 + 1];
+                float du2 = uv[v[2]*2] - uv[v[0]*2], dv2 = uv[v[2]*2 + 1] - uv[v[0]*2 + 1];
+                float r = du1*dv2 - du2*dv1;
+                r = (fabsf(r) > 1e-20f) ? 1.0f / r : 0.0f;
+                t = Vector3Scale(Vector3Subtract(Vector3Scale(e1, dv2), Vector3Scale(e2, dv1)), r);
+                b = Vector3Scale(Vector3Subtract(Vector3Scale(e2, du1), Vector3Scale(e1, du2)), r);
+            }
+            memcpy(&frames->tangents[i*3], &t, sizeof(t));
+            memcpy(&frames->bitangents[i*3], &b, sizeof(b));
+        }
+    }
+}
+
+#endif
+
+void CalcMeshNormalsEx(Mesh *mesh, MeshNormalMode mode)
+{
+    if (mode == MESH_NORMALS_FLAT && mesh->indices)
+    {
+        printf("CalcMeshNormals error: flat normals need a non-indexed mesh, calculate them before WeldMesh\n");
+        return;
+    }
+
+    int triangleCount = MeshTriangleCount(mesh);
+    if (!mesh->normals) mesh->normals = (float *)RL_MALLOC(mesh->vertexCount * 3 * sizeof(float));
+
+    // Flat normals don't need the corner angles
+    MeshTriangleFrames frames = { 0 };
+    frames.normals = (float *)RL_MALLOC(triangleCount * 3 * sizeof(float));
+    if (mode == MESH_NORMALS_SMOOTH) frames.angles = (float *)RL_MALLOC(triangleCount * 3 * sizeof(float));
+    MeshCalcTriangleFrames(mesh, &frames);
+
+    if (mode == MESH_NORMALS_FLAT)
+    {
+        for (int i = 0; i < triangleCount; i++)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                memcpy(&mesh->normals[(i*3 + k)*3], &frames.normals[i*3], 3 * sizeof(float));
+            }
+        }
+    }
+    else
+    {
+        // Corners are grouped by position, indexed or not. A mesh welded with flat normals
+        // keeps one vertex per face at every corner, grouping by index would keep it flat
+        int *group = (int *)RL_MALLOC(mesh->vertexCount * sizeof(int));
+        int *unique = (int *)RL_MALLOC(mesh->vertexCount * sizeof(int));
+        int groupCount = MeshGroupVertices(mesh, true, group, unique);
+        float *sum = (float *)RL_CALLOC(groupCount * 3, sizeof(float));
+
+        for (int i = 0; i < triangleCount; i++)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                float *s = &sum[group[MeshCorner(mesh, i*3 + k)]*3];
+                float w = frames.angles[i*3 + k];
+                s[0] += frames.normals[i*3 + 0] * w;
+                s[1] += frames.normals[i*3 + 1] * w;
+                s[2] += frames.normals[i*3 + 2] * w;
+            }
+        }
+
+        for (int v = 0; v < mesh->vertexCount; v++)
+        {
+            const float *s = &sum[group[v]*3];
+            float length = sqrtf(s[0]*s[0] + s[1]*s[1] + s[2]*s[2]);
+            float inv = length > 0 ? 1.0f / length : 0.0f;
+            mesh->normals[v*3 + 0] = s[0] * inv;
+            mesh->normals[v*3 + 1] = s[1] * inv;
+            mesh->normals[v*3 + 2] = s[2] * inv;
+        }
+
+        RL_FREE(group);
+        RL_FREE(unique);
+        RL_FREE(sum);
+    }
+
+    RL_FREE(frames.normals);
+    RL_FREE(frames.angles);
+}
+
+void CalcMeshTangents(Mesh *mesh)
+{
+    if (!mesh->normals) return;
+
+    int triangleCount = MeshTriangleCount(mesh);
+    if (!mesh->tangents) mesh->tangents = (float *)RL_MALLOC(mesh->vertexCount * 4 * sizeof(float));
+
+    MeshTriangleFrames frames = { 0 };
+    frames.normals = (float *)RL_MALLOC(triangleCount * 3 * sizeof(float));
+    frames.angles = (float *)RL_MALLOC(triangleCount * 3 * sizeof(float));
+    frames.tangents = (float *)RL_MALLOC(triangleCount * 3 * sizeof(float));
+    frames.bitangents = (float *)RL_MALLOC(triangleCount * 3 * sizeof(float));
+    MeshCalcTriangleFrames(mesh, &frames);
+
+    // Sum per vertex rather than per position, uv seams keep their own tangents
+    float *sum = (float *)RL_CALLOC(mesh->vertexCount * 6, sizeof(float));
+    for (int i = 0; i < triangleCount; i++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            float *s = &sum[MeshCorner(mesh, i*3 + k)*6];
+            float w = frames.angles[i*3 + k];
+            for (int a = 0; a < 3; a++)
+            {
+                s[a] += frames.tangents[i*3 + a] * w;
+                s[3 + a] += frames.bitangents[i*3 + a] * w;
+            }
+        }
+    }
+
+    for (int v = 0; v < mesh->vertexCount; v++)
+    {
+        Vector3 n = { mesh->normals[v*3], mesh->normals[v*3 + 1], mesh->normals[v*3 + 2] };
+        Vector3 t = { sum[v*6], sum[v*6 + 1], sum[v*6 + 2] };
+        Vector3 b = { sum[v*6 + 3], sum[v*6 + 4], sum[v*6 + 5] };
+
+        // Gram-Schmidt against the normal, w says which way the bitangent points
+        t = Vector3Subtract(t, Vector3Scale(n, Vector3DotProduct(n, t)));
+        float w = 1.0f;
+        if (Vector3LengthSqr(t) > 1e-12f)
+        {
+            t = Vector3Normalize(t);
+            if (Vector3DotProduct(Vector3CrossProduct(n, t), b) < 0) w = -1.0f;
+        }
+        else
+        {
+            // No texture coordinates to follow, any basis around the normal will do (Duff et al. 2017)
+            float sign = copysignf(1.0f, n.z);
+            float a = -1.0f / (sign + n.z);
+            t = (Vector3){ 1.0f + sign*n.x*n.x*a, sign*n.x*n.y*a, -sign*n.x };
+        }
+
+        mesh->tangents[v*4 + 0] = t.x;
+        mesh->tangents[v*4 + 1] = t.y;
+        mesh->tangents[v*4 + 2] = t.z;
+        mesh->tangents[v*4 + 3] = w;
+    }
+
+    RL_FREE(sum);
+    RL_FREE(frames.normals);
+    RL_FREE(frames.angles);
+    RL_FREE(frames.tangents);
+    RL_FREE(frames.bitangents);
+}
+
+// One interpreter shared by every mesh load, created on first use
+static lua_State *meshVM = NULL;
+
+// Copy a script array into dst: packed binary strings in one memcpy, tables with raw
+// indexed reads. Returns the number of elements the script provided.
+static int ReadLuaArray(lua_State *L, int idx, float *floats, unsigned char *bytes, int capacity)
+{
+    if (lua_type(L, idx) == LUA_TSTRING)
+    {
+        size_t size = 0;
+        const char *data = lua_tolstring(L, idx, &size);
+        int elementSize = floats ? sizeof(float) : sizeof(unsigned char);
+        int count = (int)(size / elementSize);
+        if (count > capacity) count = capacity;
+        memcpy(floats ? (void *)floats : (void *)bytes, data, count * elementSize);
+        return count;
+    }
+
+    int count = (int)lua_rawlen(L, idx);
+    if (count > capacity) count = capacity;
+    for (int i = 0; i < count; i++)
+    {
+        lua_rawgeti(L, idx, i + 1);
+        lua_Number n = lua_tonumberx(L, -1, NULL);
+        if (floats) floats[i] = (float)n;
+        else bytes[i] = (unsigned char)n;
+        lua_pop(L, 1);
+    }
+    return count;
+}
+
+static int LuaArrayLength(lua_State *L, int idx, int elementSize)
+{
+    if (lua_type(L, idx) == LUA_TSTRING) return (int)(lua_rawlen(L, idx) / elementSize);
+    if (lua_type(L, idx) == LUA_TTABLE) return (int)lua_rawlen(L, idx);
+    return 0;
+}
+
+// Mesh scripts set 'vertices' and 'colors' either as tables or, to hand the data back
+// in one go, as strings of packed little endian float32 / uint8 values, e.g.
+//     vertices = string.pack(string.rep("<f", #v), table.unpack(v))
+// Every script runs in its own environment so globals never leak between meshes, and
+// the interpreter is garbage collected after each load.
+bool ReadLuaMesh(Mesh *mesh, const char *filename)
+{
+    if (!meshVM)
+    {
+        meshVM = luaL_newstate();
+        luaL_openlibs(meshVM);
+    }
+
+    lua_State *L = meshVM;
+    int top = lua_gettop(L);
+
+    if (luaL_loadfile(L, filename) != LUA_OK)
+    {
+        printf("LoadLuaMesh error: %s\n", lua_tostring(L, -1));
+        lua_settop(L, top);
+        return false;
+    }
+
+    // Fresh _ENV for the chunk that still sees the standard library
+    lua_newtable(L);
+    lua_newtable(L);
+    lua_pushglobaltable(L);
+    lua_setfield(L, -2, "__index");
+    lua_setmetatable(L, -2);
+    lua_pushvalue(L, -1);
+    lua_setupvalue(L, -3, 1);
+
+    int env = lua_gettop(L);
+    lua_pushvalue(L, env - 1);
+    if (lua_pcall(L, 0, 0, 0) != LUA_OK)
+    {
+        printf("LoadLuaMesh error: %s\n", lua_tostring(L, -1));
+        lua_settop(L, top);
+        lua_gc(L, LUA_GCCOLLECT);
+        return false;
+    }
+
+    lua_getfield(L, env, "vertices");
+    lua_getfield(L, env, "colors");
+    int vertices = env + 1;
+    int colors = env + 2;
+
+    int len = LuaArrayLength(L, vertices, sizeof(float));
+    mesh->vertexCount = len / 3;
+    mesh->triangleCount = mesh->vertexCount / 3;
+    mesh->vertices = (float *)RL_MALLOC(mesh->vertexCount * 3 * sizeof(float));
+    mesh->normals = (float *)RL_MALLOC(mesh->vertexCount * 3 * sizeof(float));
+    mesh->colors = (unsigned char *)RL_MALLOC(mesh->vertexCount * 4 * sizeof(unsigned char));
+
+    printf("vertexCount: %d\n", mesh->vertexCount);
+    printf("triangleCount: %d\n", mesh->triangleCount);
+
+    ReadLuaArray(L, vertices, mesh->vertices, NULL, mesh->vertexCount * 3);
+
+    // Vertices without a color come out white rather than reading past the buffer
+    int colorCount = ReadLuaArray(L, colors, NULL, mesh->colors, mesh->vertexCount * 4);
+    memset(mesh->colors + colorCount, 255, mesh->vertexCount * 4 - colorCount);
+
+    lua_settop(L, top);
+    lua_gc(L, LUA_GCCOLLECT);
+    return true;
+}
+
+void UnloadLuaMeshVM(void)
+{
+    if (meshVM) lua_close(meshVM);
+    meshVM = NULL;
+}
+
+void LoadLuaMesh(Mesh *mesh, const char *filename)
+{
+    LoadLuaMeshEx(mesh, filename, 0);
+}
+
+void LoadLuaMeshEx(Mesh *mesh, const char *filename, int flags)
+{
+    if (!ReadLuaMesh(mesh, filename)) return;
+
+    CalcMeshNormalsEx(mesh, (flags & MESH_LOAD_SMOOTH) ? MESH_NORMALS_SMOOTH : MESH_NORMALS_FLAT);
+    if (flags & MESH_LOAD_TANGENTS) CalcMeshTangents(mesh);
+    if (flags & MESH_LOAD_WELD)
+    {
+        WeldMesh(mesh);
+        if (flags & MESH_LOAD_OPTIMIZE) OptimizeMeshVertexCache(mesh);
+    }
+    UploadMesh(mesh, false);
+}
+
+//----------------------------------------------------------------------------------
+// Welding and vertex cache optimization
+//----------------------------------------------------------------------------------
+
+// Attributes of vertex i as one comparable key
+typedef struct MeshVertexKey {
+    float position[3];
+    float normal[3];
+    float texcoord[2];
+    float tangent[4];
+    unsigned char color[4];
+} MeshVertexKey;
+
+static MeshVertexKey MeshGetVertexKey(const Mesh *mesh, int i, bool positionOnly)
+{
+    MeshVertexKey key;
+    memset(&key, 0, sizeof(key));
+    memcpy(key.position, &mesh->vertices[i*3], sizeof(key.position));
+    if (positionOnly) return key;
+    if (mesh->normals) memcpy(key.normal, &mesh->normals[i*3], sizeof(key.normal));
+    if (mesh->texcoords) memcpy(key.texcoord, &mesh->texcoords[i*2], sizeof(key.texcoord));
+    if (mesh->tangents) memcpy(key.tangent, &mesh->tangents[i*4], sizeof(key.tangent));
+    if (mesh->colors) memcpy(key.color, &mesh->colors[i*4], sizeof(key.color));
+    return key;
+}
+
+// Number the distinct vertices in order of first appearance: remap[i] is the number of
+// vertex i, unique[n] the first vertex numbered n. Returns how many there are.
+static int MeshGroupVertices(const Mesh *mesh, bool positionOnly, int *remap, int *unique)
+{
+    int count = mesh->vertexCount;
+    int capacity = 1;
+    while (capacity < count*2) capacity <<= 1;
+
+    // Open addressing table of unique vertex numbers, -1 for empty slots
+    int *table = (int *)RL_MALLOC(capacity * sizeof(int));
+    memset(table, 0xff, capacity * sizeof(int));
+    int uniqueCount = 0;
+
+    size_t keySize = positionOnly ? sizeof(((MeshVertexKey *)0)->position) : sizeof(MeshVertexKey);
+    for (int i = 0; i < count; i++)
+    {
+        MeshVertexKey key = MeshGetVertexKey(mesh, i, positionOnly);
+        uint64_t hash = MeshFileHash(&key, keySize);
+        int slot = (int)(hash & (capacity - 1));
+
+        while (table[slot] >= 0)
+        {
+            MeshVertexKey other = MeshGetVertexKey(mesh, unique[table[slot]], positionOnly);
+            if (memcmp(&key, &other, keySize) == 0) break;
+            slot = (slot + 1) & (capacity - 1);
+        }
+
+        if (table[slot] < 0)
+        {
+            table[slot] = uniqueCount;
+            unique[uniqueCount++] = i;
+        }
+        remap[i] = table[slot];
+    }
+
+    RL_FREE(table);
+    return uniqueCount;
+}
+
+bool WeldMesh(Mesh *mesh)
+{
+    if (mesh->indices || mesh->vertexCount == 0) return false;
+
+    int count = mesh->vertexCount;
+    int *remap = (int *)RL_MALLOC(count * sizeof(int));
+    int *unique = (int *)RL_MALLOC(count * sizeof(int));
+    int uniqueCount = MeshGroupVertices(mesh, false, remap, unique);
+
+    // raylib index buffers are 16 bit
+    if (uniqueCount > 65535)
+    {
+        printf("WeldMesh: %d unique vertices don't fit 16 bit indices, keeping the mesh unindexed\n", uniqueCount);
+        RL_FREE(remap);
+        RL_FREE(unique);
+        return false;
+    }
+
+    mesh->indices = (unsigned short *)RL_MALLOC(count * sizeof(unsigned short));
+    for (int i = 0; i < count; i++)
+    {
+        mesh->indices[i] = (unsigned short)remap[i];
+    }
+
+    // Compact the vertex streams in place, unique[] is increasing so nothing is overwritten early
+    for (int i = 0; i < uniqueCount; i++)
+    {
+        int from = unique[i];
+        memmove(&mesh->vertices[i*3], &mesh->vertices[from*3], 3 * sizeof(float));
+        if (mesh->normals) memmove(&mesh->normals[i*3], &mesh->normals[from*3], 3 * sizeof(float));
+        if (mesh->texcoords) memmove(&mesh->texcoords[i*2], &mesh->texcoords[from*2], 2 * sizeof(float));
+        if (mesh->tangents) memmove(&mesh->tangents[i*4], &mesh->tangents[from*4], 4 * sizeof(float));
+        if (mesh->colors) memmove(&mesh->colors[i*4], &mesh->colors[from*4], 4 * sizeof(unsigned char));
+    }
+
+    mesh->vertexCount = uniqueCount;
+
+    RL_FREE(remap);
+    RL_FREE(unique);
+    return true;
+}
+
+// Tom Forsyth's "Linear-speed vertex cache optimisation" scoring
+static float MeshVertexScore(int activeTriangles, int cachePosition)
+{
+    if (activeTriangles == 0) return -1.0f;
+
+    float score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        // The triangle just drawn is used whichever way round it went in
+        if (cachePosition < 3) score = 0.75f;
+        else score = powf(1.0f - (float)(cachePosition - 3) / (MESH_CACHE_SIZE - 3), 1.5f);
+    }
+
+    // Favour vertices with few triangles left so they leave the cache for good
+    return score + 2.0f / sqrtf((float)activeTriangles);
+}
+
+void OptimizeMeshVertexCache(Mesh *mesh)
+{
+    if (!mesh->indices) return;
+
+    int triangleCount = mesh->triangleCount;
+    int vertexCount = mesh->vertexCount;
+    unsigned short *indices = mesh->indices;
+
+    // Triangles using each vertex, packed as offsets into one array
+    int *activeCount = (int *)RL_CALLOC(vertexCount, sizeof(int));
+    int *offsets = (int *)RL_MALLOC((vertexCount + 1) * sizeof(int));
+    int *adjacency = (int *)RL_MALLOC(triangleCount * 3 * sizeof(int));
+    for (int i = 0; i < triangleCount * 3; i++) activeCount[indices[i]]++;
+    offsets[0] = 0;
+    for (int v = 0; v < vertexCount; v++) offsets[v + 1] = offsets[v] + activeCount[v];
+    int *fill = (int *)RL_CALLOC(vertexCount, sizeof(int));
+    for (int i = 0; i < triangleCount * 3; i++)
+    {
+        int v = indices[i];
+        adjacency[offsets[v] + fill[v]++] = i / 3;
+    }
+    RL_FREE(fill);
+
+    int *cachePosition = (int *)RL_MALLOC(vertexCount * sizeof(int));
+    float *vertexScore = (float *)RL_MALLOC(vertexCount * sizeof(float));
+    float *triangleScore = (float *)RL_MALLOC(triangleCount * sizeof(float));
+    bool *emitted = (bool *)RL_CALLOC(triangleCount, sizeof(bool));
+    unsigned short *output = (unsigned short *)RL_MALLOC(triangleCount * 3 * sizeof(unsigned short));
+
+    for (int v = 0; v < vertexCount; v++)
+    {
+        cachePosition[v] = -1;
+        vertexScore[v] = MeshVertexScore(activeCount[v], -1);
+    }
+    for (int t = 0; t < triangleCount; t++)
+    {
+        triangleScore[t] = vertexScore[indices[t*3]] + vertexScore[indices[t*3 + 1]] + vertexScore[indices[t*3 + 2]];
+    }
+
+    int cache[MESH_CACHE_SIZE + 3];
+    int cacheCount = 0;
+    int best = -1;
+    int scanFrom = 0;
+
+    for (int emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+    {
+        // Nothing useful in the cache, fall back to the first remaining triangle
+        if (best < 0)
+        {
+            while (emitted[scanFrom]) scanFrom++;
+            best = scanFrom;
+        }
+
+        emitted[best] = true;
+        memcpy(&output[emittedCount*3], &indices[best*3], 3 * sizeof(unsigned short));
+
+        // Move the triangle's vertices to the front of the LRU cache
+        int newCache[MESH_CACHE_SIZE + 3];
+        int newCount = 0;
+        for (int k = 0; k < 3; k++)
+        {
+            int v = indices[best*3 + k];
+            newCache[newCount++] = v;
+
+            // Retire the triangle from the vertex's list
+            int *list = &adjacency[offsets[v]];
+            for (int j = 0; j < activeCount[v]; j++)
+            {
+                if (list[j] == best)
+                {
+                    list[j] = list[activeCount[v] - 1];
+                    break;
+                }
+            }
+            activeCount[v]--;
+        }
+        for (int i = 0; i < cacheCount; i++)
+        {
+            int v = cache[i];
+            if (v != newCache[0] && v != newCache[1] && v != newCache[2]) newCache[newCount++] = v;
+        }
+
+        // Rescore everything that was or is in the cache and pick the best triangle among them
+        best = -1;
+        float bestScore = -1.0f;
+        for (int i = 0; i < newCount; i++)
+        {
+            int v = newCache[i];
+            cachePosition[v] = (i < MESH_CACHE_SIZE) ? i : -1;
+            vertexScore[v] = MeshVertexScore(activeCount[v], cachePosition[v]);
+        }
+        for (int i = 0; i < newCount; i++)
+        {
+            int v = newCache[i];
+            for (int j = 0; j < activeCount[v]; j++)
+            {
+                int t = adjacency[offsets[v] + j];
+                triangleScore[t] = vertexScore[indices[t*3]] + vertexScore[indices[t*3 + 1]] + vertexScore[indices[t*3 + 2]];
+                if (triangleScore[t] > bestScore)
+                {
+                    bestScore = triangleScore[t];
+                    best = t;
+                }
+            }
+        }
+
+        cacheCount = newCount < MESH_CACHE_SIZE ? newCount : MESH_CACHE_SIZE;
+        memcpy(cache, newCache, cacheCount * sizeof(int));
+    }
+
+    memcpy(indices, output, triangleCount * 3 * sizeof(unsigned short));
+
+    // Renumber vertices in first use order so vertex fetch walks memory forwards
+    int *order = cachePosition;
+    for (int v = 0; v < vertexCount; v++) order[v] = -1;
+    int next = 0;
+    for (int i = 0; i < triangleCount * 3; i++)
+    {
+        if (order[indices[i]] < 0) order[indices[i]] = next++;
+        indices[i] = (unsigned short)order[indices[i]];
+    }
+
+    float *vertices = (float *)RL_MALLOC(vertexCount * 3 * sizeof(float));
+    float *normals = mesh->normals ? (float *)RL_MALLOC(vertexCount * 3 * sizeof(float)) : NULL;
+    float *texcoords = mesh->texcoords ? (float *)RL_MALLOC(vertexCount * 2 * sizeof(float)) : NULL;
+    float *tangents = mesh->tangents ? (float *)RL_MALLOC(vertexCount * 4 * sizeof(float)) : NULL;
+    unsigned char *colors = mesh->colors ? (unsigned char *)RL_MALLOC(vertexCount * 4) : NULL;
+    for (int v = 0; v < vertexCount; v++)
+    {
+        // Vertices no triangle uses go to the end
+        int to = order[v] >= 0 ? order[v] : next++;
+        memcpy(&vertices[to*3], &mesh->vertices[v*3], 3 * sizeof(float));
+        if (normals) memcpy(&normals[to*3], &mesh->normals[v*3], 3 * sizeof(float));
+        if (texcoords) memcpy(&texcoords[to*2], &mesh->texcoords[v*2], 2 * sizeof(float));
+        if (tangents) memcpy(&tangents[to*4], &mesh->tangents[v*4], 4 * sizeof(float));
+        if (colors) memcpy(&colors[to*4], &mesh->colors[v*4], 4);
+    }
+    RL_FREE(mesh->vertices);
+    RL_FREE(mesh->normals);
+    RL_FREE(mesh->texcoords);
+    RL_FREE(mesh->tangents);
+    RL_FREE(mesh->colors);
+    mesh->vertices = vertices;
+    mesh->normals = normals;
+    mesh->texcoords = texcoords;
+    mesh->tangents = tangents;
+    mesh->colors = colors;
+
+    RL_FREE(activeCount);
+    RL_FREE(offsets);
+    RL_FREE(adjacency);
+    RL_FREE(cachePosition);
+    RL_FREE(vertexScore);
+    RL_FREE(triangleScore);
+    RL_FREE(emitted);
+    RL_FREE(output);
+}
+
+float GetMeshACMR(Mesh mesh, int cacheSize)
+{
+    if (mesh.triangleCount == 0) return 0.0f;
+    if (!mesh.indices) return 3.0f;
+
+    // Simulated FIFO post-transform cache
+    int *fifo = (int *)RL_MALLOC(cacheSize * sizeof(int));
+    for (int i = 0; i < cacheSize; i++) fifo[i] = -1;
+    int head = 0;
+    int misses = 0;
+
+    for (int i = 0; i < mesh.triangleCount * 3; i++)
+    {
+        int v = mesh.indices[i];
+        bool hit = false;
+        for (int j = 0; j < cacheSize && !hit; j++) hit = fifo[j] == v;
+        if (!hit)
+        {
+            fifo[head] = v;
+            head = (head + 1) % cacheSize;
+            misses++;
+        }
+    }
+
+    RL_FREE(fifo);
+    return (float)misses / mesh.triangleCount;
+}
+
+//----------------------------------------------------------------------------------
+// Packed vertices
+//----------------------------------------------------------------------------------
+
+// UnloadMesh releases MAX_MESH_VERTEX_BUFFERS vboId entries, a raylib build setting (7 up
+// to raylib 5.0, 9 since the bone buffers in 5.5). Allocate past any of them, zeroed so
+// the slots we don't use are skipped
+#define MESH_VERTEX_BUFFERS     16
+
+// Slot UploadMesh keeps the index buffer in
+#if defined(RL_DEFAULT_SHADER_ATTRIB_LOCATION_INDICES)
+    #define MESH_INDEX_BUFFER   RL_DEFAULT_SHADER_ATTRIB_LOCATION_INDICES
+#else
+    #define MESH_INDEX_BUFFER   6
+#endif
+
+static int MeshPaletteIndex(MeshPalette *palette, Color color)
+{
+    for (int i = 0; i < palette->count; i++)
+    {
+        Color c = palette->colors[i];
+        if (c.r == color.r && c.g == color.g && c.b == color.b && c.a == color.a) return i;
+    }
+
+    if (palette->count == MESH_PALETTE_SIZE) return -1;
+    palette->colors[palette->count] = color;
+    return palette->count++;
+}
+
+bool PackMesh(Mesh mesh, float positionScale, MeshPalette *palette, PackedVertex *packed)
+{
+    if (!mesh.normals) return false;
+
+    for (int i = 0; i < mesh.vertexCount; i++)
+    {
+        PackedVertex *pv = &packed[i];
+
+        for (int k = 0; k < 3; k++)
+        {
+            float p = mesh.vertices[i*3 + k] / positionScale;
+            float q = roundf(p);
+            if (fabsf(p - q) > 1e-3f || q < -32768.0f || q > 32767.0f) return false;
+            pv->position[k] = (short)q;
+        }
+
+        // Only the six lattice normals are representable
+        const float *n = &mesh.normals[i*3];
+        int face = -1;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            if (fabsf(n[axis]) > 0.999f) face = axis*2 + (n[axis] < 0 ? 1 : 0);
+        }
+        if (face < 0) return false;
+        pv->face = (unsigned char)face;
+
+        Color color = mesh.colors ? (Color){ mesh.colors[i*4], mesh.colors[i*4 + 1], mesh.colors[i*4 + 2], mesh.colors[i*4 + 3] } : WHITE;
+        int index = MeshPaletteIndex(palette, color);
+        if (index < 0) return false;
+        pv->color = (unsigned char)index;
+    }
+
+    return true;
+}
+
+bool UploadMeshPacked(Mesh *mesh, float positionScale, MeshPalette *palette)
+{
+    PackedVertex *packed = (PackedVertex *)RL_MALLOC(mesh->vertexCount * sizeof(PackedVertex));
+    MeshPalette trial = *palette;
+    if (!PackMesh(*mesh, positionScale, &trial, packed))
+    {
+        RL_FREE(packed);
+        return false;
+    }
+    *palette = trial;
+
+    // Same buffer slots UploadMesh uses so DrawMesh and UnloadMesh handle the result
+    mesh->vboId = (unsigned int *)RL_CALLOC(MESH_VERTEX_BUFFERS, sizeof(unsigned int));
+    mesh->vaoId = rlLoadVertexArray();
+    rlEnableVertexArray(mesh->vaoId);
+
+    mesh->vboId[0] = rlLoadVertexBuffer(packed, mesh->vertexCount * sizeof(PackedVertex), false);
+    rlSetVertexAttribute(0, 3, RL_SHORT, false, sizeof(PackedVertex), (void *)offsetof(PackedVertex, position));
+    rlEnableVertexAttribute(0);
+    rlSetVertexAttribute(1, 2, RL_UNSIGNED_BYTE, false, sizeof(PackedVertex), (void *)offsetof(PackedVertex, face));
+    rlEnableVertexAttribute(1);
+
+    if (mesh->indices)
+    {
+        mesh->vboId[MESH_INDEX_BUFFER] = rlLoadVertexBufferElement(mesh->indices, mesh->triangleCount * 3 * sizeof(unsigned short), false);
+    }
+
+    rlDisableVertexArray();
+    RL_FREE(packed);
+
+    // The GPU copy is all that's drawn, indices stay since DrawMesh checks them
+    RL_FREE(mesh->vertices);
+    RL_FREE(mesh->normals);
+    RL_FREE(mesh->colors);
+    mesh->vertices = NULL;
+    mesh->normals = NULL;
+    mesh->colors = NULL;
+
+    return true;
+}
+
+void SetShaderPalette(Shader shader, const MeshPalette *palette, float positionScale)
+{
+    Vector3 colors[MESH_PALETTE_SIZE] = {0};
+    for (int i = 0; i < palette->count; i++)
+    {
+        colors[i] = (Vector3){ palette->colors[i].r / 255.0f, palette->colors[i].g / 255.0f, palette->colors[i].b / 255.0f };
+    }
+
+    SetShaderValueV(shader, GetShaderLocation(shader, "palette"), colors, SHADER_UNIFORM_VEC3, MESH_PALETTE_SIZE);
+    SetShaderValue(shader, GetShaderLocation(shader, "positionScale"), &positionScale, SHADER_UNIFORM_FLOAT);
+}
+
+uint64_t MeshFileHash(const void *data, size_t size)
+{
+    const unsigned char *p = (const unsigned char *)data;
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= p[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static uint64_t MeshFileAlign(uint64_t offset)
+{
+    return (offset + MESH_FILE_ALIGN - 1) & ~(uint64_t)(MESH_FILE_ALIGN - 1);
+}
+
+bool ExportMeshBinary(Mesh mesh, const char *fileName)
+{
+    const void *streams[MESH_STREAM_COUNT] = { mesh.vertices, mesh.normals, mesh.colors, mesh.indices };
+    uint64_t sizes[MESH_STREAM_COUNT] = {
+        mesh.vertices ? mesh.vertexCount * 3 * sizeof(float) : 0,
+        mesh.normals ? mesh.vertexCount * 3 * sizeof(float) : 0,
+        mesh.colors ? mesh.vertexCount * 4 * sizeof(unsigned char) : 0,
+        mesh.indices ? mesh.triangleCount * 3 * sizeof(unsigned short) : 0,
+    };
+
+    MeshFileHeader header = {0};
+    header.magic = MESH_FILE_MAGIC;
+    header.version = MESH_FILE_VERSION;
+    header.vertexCount = mesh.vertexCount;
+    header.triangleCount = mesh.triangleCount;
+    header.indexCount = mesh.indices ? mesh.triangleCount * 3 : 0;
+
+    uint64_t offset = MeshFileAlign(sizeof(MeshFileHeader));
+    for (int i = 0; i < MESH_STREAM_COUNT; i++)
+    {
+        header.streams[i].offset = offset;
+        header.streams[i].size = sizes[i];
+        offset = MeshFileAlign(offset + sizes[i]);
+    }
+
+    // Assemble the whole file so the hash covers exactly what gets written
+    size_t fileSize = (size_t)offset;
+    unsigned char *data = (unsigned char *)RL_CALLOC(fileSize, 1);
+    for (int i = 0; i < MESH_STREAM_COUNT; i++)
+    {
+        if (sizes[i]) memcpy(data + header.streams[i].offset, streams[i], sizes[i]);
+    }
+    header.hash = MeshFileHash(data + sizeof(MeshFileHeader), fileSize - sizeof(MeshFileHeader));
+    memcpy(data, &header, sizeof(MeshFileHeader));
+
+    FILE *f = fopen(fileName, "wb");
+    bool ok = f && fwrite(data, 1, fileSize, f) == fileSize;
+    if (f) fclose(f);
+    RL_FREE(data);
+
+    if (!ok) printf("ExportMeshBinary error: can't write %s\n", fileName);
+    return ok;
+}
+
+static bool MeshFileOpen(const char *fileName, MeshFile *file)
+{
+    *file = (MeshFile){0};
+
+#if defined(_WIN32)
+    // No mmap here: one read into a single buffer, still no per element parsing
+    FILE *f = fopen(fileName, "rb");
+    if (!f) return false;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    file->data = RL_MALLOC(size > 0 ? size : 1);
+    file->size = (size_t)size;
+    bool ok = size > 0 && fread(file->data, 1, file->size, f) == file->size;
+    fclose(f);
+    if (!ok)
+    {
+        RL_FREE(file->data);
+        *file = (MeshFile){0};
+    }
+    return ok;
+#else
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    // Private writable mapping so CalcMeshNormals and friends still work (copy on write)
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return false;
+
+    file->data = data;
+    file->size = (size_t)st.st_size;
+    file->mapped = true;
+    return true;
+#endif
+}
+
+static void MeshFileClose(MeshFile *file)
+{
+#if !defined(_WIN32)
+    if (file->mapped)
+    {
+        munmap(file->data, file->size);
+        *file = (MeshFile){0};
+        return;
+    }
+#endif
+    RL_FREE(file->data);
+    *file = (MeshFile){0};
+}
+
+// Header counts, stream sizes and indices agree and every stream lies inside the file
+static bool MeshFileValid(const MeshFile *file)
+{
+    const MeshFileHeader *header = (const MeshFileHeader *)file->data;
+    if (file->size < sizeof(MeshFileHeader) || header->magic != MESH_FILE_MAGIC || header->version != MESH_FILE_VERSION) return false;
+    if (header->vertexCount > INT_MAX || header->triangleCount > INT_MAX/3) return false;
+
+    uint64_t vertices = header->vertexCount;
+    uint64_t indices = (uint64_t)header->triangleCount * 3;
+    uint64_t sizes[MESH_STREAM_COUNT] = {
+        vertices * 3 * sizeof(float),
+        vertices * 3 * sizeof(float),
+        vertices * 4 * sizeof(unsigned char),
+        indices * sizeof(unsigned short),
+    };
+
+    for (int i = 0; i < MESH_STREAM_COUNT; i++)
+    {
+        // Positions are required, the other streams may be left out
+        const MeshFileStream *stream = &header->streams[i];
+        if (stream->size == 0 && i != MESH_STREAM_POSITIONS) continue;
+        if (stream->size != sizes[i] || stream->offset % MESH_FILE_ALIGN != 0) return false;
+        if (stream->size > file->size || stream->offset > file->size - stream->size) return false;     // No offset + size wrap around
+    }
+
+    // Unindexed meshes draw vertexCount vertices, their triangles must fit in them
+    const MeshFileStream *stream = &header->streams[MESH_STREAM_INDICES];
+    if (stream->size == 0) return header->indexCount == 0 && indices <= vertices;
+    if (header->indexCount != indices) return false;
+
+    const unsigned short *index = (const unsigned short *)((const unsigned char *)file->data + stream->offset);
+    for (uint64_t i = 0; i < indices; i++)
+    {
+        if (index[i] >= vertices) return false;
+    }
+
+    return true;
+}
+
+Mesh LoadMeshBinary(const char *fileName, MeshFile *file)
+{
+    Mesh mesh = {0};
+    if (!MeshFileOpen(fileName, file))
+    {
+        printf("LoadMeshBinary error: can't open %s\n", fileName);
+        return mesh;
+    }
+
+    if (!MeshFileValid(file))
+    {
+        printf("LoadMeshBinary error: %s is not a version %d mesh file\n", fileName, MESH_FILE_VERSION);
+        MeshFileClose(file);
+        return mesh;
+    }
+
+    const MeshFileHeader *header = (const MeshFileHeader *)file->data;
+    unsigned char *base = (unsigned char *)file->data;
+    const MeshFileStream *streams = header->streams;
+    mesh.vertexCount = header->vertexCount;
+    mesh.triangleCount = header->triangleCount;
+    if (streams[MESH_STREAM_POSITIONS].size) mesh.vertices = (float *)(base + streams[MESH_STREAM_POSITIONS].offset);
+    if (streams[MESH_STREAM_NORMALS].size) mesh.normals = (float *)(base + streams[MESH_STREAM_NORMALS].offset);
+    if (streams[MESH_STREAM_COLORS].size) mesh.colors = base + streams[MESH_STREAM_COLORS].offset;
+    if (streams[MESH_STREAM_INDICES].size) mesh.indices = (unsigned short *)(base + streams[MESH_STREAM_INDICES].offset);
+
+    return mesh;
+}
+
+bool VerifyMeshBinary(const MeshFile *file)
+{
+    const MeshFileHeader *header = (const MeshFileHeader *)file->data;
+    if (!header || file->size < sizeof(MeshFileHeader)) return false;
+    return MeshFileHash((const unsigned char *)file->data + sizeof(MeshFileHeader), file->size - sizeof(MeshFileHeader)) == header->hash;
+}
+
+void UnloadMeshBinary(MeshFile *file, Mesh *mesh)
+{
+    if (!file->data) return;
+
+    // Only drop pointers into the file, anything allocated later stays with the mesh
+    unsigned char *begin = (unsigned char *)file->data;
+    unsigned char *end = begin + file->size;
+#define MESH_IN_FILE(p) ((unsigned char *)(p) >= begin && (unsigned char *)(p) < end)
+    if (MESH_IN_FILE(mesh->vertices)) mesh->vertices = NULL;
+    if (MESH_IN_FILE(mesh->normals)) mesh->normals = NULL;
+    if (MESH_IN_FILE(mesh->colors)) mesh->colors = NULL;
+    if (MESH_IN_FILE(mesh->indices)) mesh->indices = NULL;
+#undef MESH_IN_FILE
+
+    MeshFileClose(file);
+}
+
+#endif // MESH_IMPLEMENTATION
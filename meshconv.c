@@ -0,0 +1,66 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "raylib.h"
+
+#define MESH_IMPLEMENTATION
+#include "mesh.h"
+
+// Offline converter from Lua mesh scripts to the binary mesh format
+//
+//   meshconv mesh/cube.lua             writes mesh/cube.mesh
+//   meshconv mesh/*.lua                converts every script
+//   meshconv in.lua -o out.mesh        explicit output name
+
+bool ConvertMesh(const char *input, const char *output)
+{
+    Mesh mesh = {0};
+    if (!ReadLuaMesh(&mesh, input)) return false;
+
+    CalcMeshNormals(&mesh);
+    if (WeldMesh(&mesh)) OptimizeMeshVertexCache(&mesh);
+
+    bool ok = ExportMeshBinary(mesh, output);
+    if (ok) printf("%s -> %s (%d vertices, %d triangles)\n", input, output, mesh.vertexCount, mesh.triangleCount);
+
+    RL_FREE(mesh.vertices);
+    RL_FREE(mesh.normals);
+    RL_FREE(mesh.colors);
+    RL_FREE(mesh.indices);
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        printf("usage: meshconv <mesh.lua>... | meshconv <mesh.lua> -o <out.mesh>\n");
+        return 1;
+    }
+
+    if (argc == 4 && strcmp(argv[2], "-o") == 0)
+    {
+        bool ok = ConvertMesh(argv[1], argv[3]);
+        UnloadLuaMeshVM();
+        return ok ? 0 : 1;
+    }
+
+    int failed = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        // Swap the extension for .mesh
+        char output[1024];
+        snprintf(output, sizeof(output), "%s", argv[i]);
+        char *ext = strrchr(output, '.');
+        char *slash = strrchr(output, '/');
+        if (ext && (!slash || ext > slash)) *ext = '\0';
+        if (strlen(output) + 6 > sizeof(output)) { failed++; continue; }
+        strcat(output, ".mesh");
+
+        if (!ConvertMesh(argv[i], output)) failed++;
+    }
+
+    UnloadLuaMeshVM();
+
+    return failed ? 1 : 0;
+}
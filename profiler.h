@@ -0,0 +1,468 @@
+/**********************************************************************************************
+*
+*   profiler - Frame zone profiler with CPU and GPU timings
+*
+*   Zones are named by string literals and nest: BeginProfileZone pushes the zone and reads
+*   the clock, EndProfileZone pops it and appends one event to a ring buffer, so a zone
+*   costs two clock reads and a few stores and can stay on. On x86 the clock is the time
+*   stamp counter (invariant on every CPU this runs on), calibrated against raylib's GetTime
+*   in InitProfiler; elsewhere it is GetTime itself, about twice the cost per zone. GetTime
+*   keeps the library plain C99 on every platform, but it only runs once the window is up,
+*   so call InitProfiler after InitWindow.
+*
+*   GPU zones put a GL_TIMESTAMP query at both ends. The pending rlgl batch is flushed first
+*   so the draws issued inside the zone are really in it. Queries are read back
+*   PROFILER_GPU_LATENCY frames later, when the GPU is long done with them, so reading never
+*   stalls the pipeline. Platforms without GL 3.3 entry points in their GL headers (Windows)
+*   and builds defining PROFILER_NO_GPU only get CPU zones.
+*
+*   Per zone, the time spent in every frame of the last PROFILER_HISTORY frames is kept for
+*   the percentiles DrawProfiler shows. ExportProfileTrace writes the events still in the
+*   ring as Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev), CPU zones on one
+*   track and GPU zones, shifted into the CPU clock, on another.
+*
+*   Counters (chunks drawn, rays traced, ...) are set once per frame with SetProfileCounter,
+*   DrawProfiler lists their latest values and the trace export plots them as counter tracks.
+*
+*   Call BeginProfileFrame before anything else of the frame and EndProfileFrame after
+*   EndDrawing, the whole frame is recorded as the "frame" zone.
+*
+*   CONFIGURATION:
+*
+*   #define PROFILER_IMPLEMENTATION
+*       Generates the implementation of the library into the included file.
+*       Only ONE file should hold the implementation.
+*
+*   #define PROFILER_NO_GPU
+*       Compile out the GL timer queries, GPU zones do nothing.
+*
+**********************************************************************************************/
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "raylib.h"
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define PROFILER_MAX_ZONES      32      // Distinct zone names
+#define PROFILER_MAX_COUNTERS   16      // Distinct counter names
+#define PROFILER_MAX_DEPTH      16      // Nesting of open CPU zones
+#define PROFILER_MAX_EVENTS     65536   // Events kept for the trace export, power of 2
+#define PROFILER_HISTORY        256     // Frames kept for percentiles
+#define PROFILER_GPU_ZONES      16      // GPU zones per frame
+#define PROFILER_GPU_LATENCY    4       // Frames between issuing and reading timer queries
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct ProfileEvent {
+    unsigned short zone;        // Index in the zone table
+    unsigned short depth;       // Open zones around it, 0 for the frame
+    unsigned int frame;
+    long long start;            // Profiler clock ticks, nanoseconds unless running on the TSC
+    long long end;
+} ProfileEvent;
+
+typedef struct ProfileCounterEvent {
+    unsigned short counter;     // Index in the counter table
+    unsigned int frame;
+    long long time;             // Profiler clock ticks when the value was set
+    double value;
+} ProfileCounterEvent;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+void InitProfiler(void);                        // Call after InitWindow, GPU zones need the GL context
+void UnloadProfiler(void);
+void BeginProfileFrame(void);
+void EndProfileFrame(void);                     // After EndDrawing, so present is part of the frame
+void BeginProfileZone(const char *name);        // name must outlive the profiler, a literal is fine
+void EndProfileZone(void);                      // Closes the innermost CPU zone
+void BeginProfileGpuZone(const char *name);     // GPU zones do not nest
+void EndProfileGpuZone(void);
+void SetProfileCounter(const char *name, double value);  // name must outlive the profiler, like zone names
+void DrawProfiler(int posX, int posY);          // p50/p95/p99 of every zone over the recent frames
+bool ExportProfileTrace(const char *fileName);  // Chrome trace-event JSON of the recorded events
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PROFILER_H
+
+/***********************************************************************************
+*
+*   PROFILER IMPLEMENTATION
+*
+************************************************************************************/
+
+#if defined(PROFILER_IMPLEMENTATION) && !defined(PROFILER_IMPLEMENTED)
+#define PROFILER_IMPLEMENTED
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+    #define PROFILER_TSC
+#endif
+
+#if defined(_WIN32) && !defined(PROFILER_NO_GPU)
+    #define PROFILER_NO_GPU
+#endif
+
+#if !defined(PROFILER_NO_GPU)
+    #include "rlgl.h"
+    #if defined(__APPLE__)
+        #include <OpenGL/gl3.h>
+    #else
+        #define GL_GLEXT_PROTOTYPES
+        #include <GL/gl.h>
+        #include <GL/glext.h>
+    #endif
+#endif
+
+typedef struct ProfileGpuFrame {
+    int count;                          // Zones issued in the frame
+    unsigned int frame;
+    long long offset;                   // CPU clock minus GPU clock in nanoseconds when the frame began
+    unsigned short zones[PROFILER_GPU_ZONES];
+#if !defined(PROFILER_NO_GPU)
+    GLuint queries[PROFILER_GPU_ZONES*2];
+#endif
+} ProfileGpuFrame;
+
+static struct {
+    int zoneCount;
+    const char *names[PROFILER_MAX_ZONES];
+    bool gpu[PROFILER_MAX_ZONES];       // Zone times GPU work, listed separately
+
+    int depth;
+    unsigned short stackZones[PROFILER_MAX_DEPTH];
+    long long stackStarts[PROFILER_MAX_DEPTH];
+
+    unsigned int frame;                 // Frames begun since InitProfiler
+    long long frameStart;
+    long long frameTicks[PROFILER_MAX_ZONES];               // Ticks spent in the current frame
+    float history[PROFILER_MAX_ZONES][PROFILER_HISTORY];    // Milliseconds per zone and frame
+
+    ProfileEvent *events;
+    unsigned int eventCount;            // Total appended, the ring holds the last PROFILER_MAX_EVENTS
+    ProfileEvent *gpuEvents;
+    unsigned int gpuEventCount;
+
+    int counterCount;
+    const char *counterNames[PROFILER_MAX_COUNTERS];
+    double counterValues[PROFILER_MAX_COUNTERS];            // Latest value of each counter
+    ProfileCounterEvent *counterEvents;
+    unsigned int counterEventCount;
+
+    int gpuOpen;                        // Slot of the open GPU zone, -1 when none
+    ProfileGpuFrame gpuFrames[PROFILER_GPU_LATENCY];
+
+    unsigned long long tscBase;         // Counter value at InitProfiler
+    double nsPerTick;                   // 1 on GetTime
+    long long origin;                   // Ticks at InitProfiler, time 0 of the trace
+} profiler = { 0 };
+
+// Nanoseconds since InitWindow, a double holds them exactly for over three months
+static inline long long ProfilerClock(void)
+{
+    return (long long)(GetTime()*1e9);
+}
+
+// Raw ticks, zones only convert them when the frame ends or the trace is written
+static inline long long ProfilerNow(void)
+{
+#if defined(PROFILER_TSC)
+    return (long long)(__rdtsc() - profiler.tscBase);
+#else
+    return ProfilerClock();
+#endif
+}
+
+// Zone names are almost always the same literal, so compare pointers before strings
+static int ProfilerZone(const char *name, bool gpu)
+{
+    for (int i = 0; i < profiler.zoneCount; i++)
+    {
+        if (profiler.names[i] == name && profiler.gpu[i] == gpu) return i;
+    }
+    for (int i = 0; i < profiler.zoneCount; i++)
+    {
+        if (profiler.gpu[i] == gpu && strcmp(profiler.names[i], name) == 0) return i;
+    }
+    if (profiler.zoneCount == PROFILER_MAX_ZONES) return PROFILER_MAX_ZONES - 1;
+
+    profiler.names[profiler.zoneCount] = name;
+    profiler.gpu[profiler.zoneCount] = gpu;
+    return profiler.zoneCount++;
+}
+
+#if !defined(PROFILER_NO_GPU)
+static long long ProfilerGpuNow(void)
+{
+    GLint64 now = 0;
+    glGetInteger64v(GL_TIMESTAMP, &now);
+    return (long long)now;
+}
+
+// Collect the queries a slot issued PROFILER_GPU_LATENCY frames ago
+static void ProfilerResolveGpu(ProfileGpuFrame *slot)
+{
+    for (int i = 0; i < slot->count; i++)
+    {
+        GLuint64 start = 0, end = 0;
+        glGetQueryObjectui64v(slot->queries[i*2], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(slot->queries[i*2 + 1], GL_QUERY_RESULT, &end);
+
+        ProfileEvent event = { slot->zones[i], 0, slot->frame,
+            (long long)(((long long)start + slot->offset)/profiler.nsPerTick), (long long)(((long long)end + slot->offset)/profiler.nsPerTick) };
+        profiler.gpuEvents[profiler.gpuEventCount++ & (PROFILER_MAX_EVENTS - 1)] = event;
+
+        // Old enough frames have rolled out of the history already
+        if (profiler.frame - slot->frame < PROFILER_HISTORY) profiler.history[slot->zones[i]][slot->frame % PROFILER_HISTORY] += (end - start)/1e6f;
+    }
+    slot->count = 0;
+}
+#endif
+
+void InitProfiler(void)
+{
+    memset(&profiler, 0, sizeof(profiler));
+    profiler.events = (ProfileEvent *)RL_MALLOC(PROFILER_MAX_EVENTS*sizeof(ProfileEvent));
+    profiler.gpuEvents = (ProfileEvent *)RL_MALLOC(PROFILER_MAX_EVENTS*sizeof(ProfileEvent));
+    profiler.counterEvents = (ProfileCounterEvent *)RL_MALLOC(PROFILER_MAX_EVENTS*sizeof(ProfileCounterEvent));
+    profiler.gpuOpen = -1;
+    profiler.frame = (unsigned int)-1;
+    profiler.nsPerTick = 1.0;
+
+#if defined(PROFILER_TSC)
+    // A few milliseconds against GetTime pin the counter rate well below 0.1%
+    long long clockStart = ProfilerClock();
+    unsigned long long tscStart = __rdtsc();
+    while (ProfilerClock() - clockStart < 5000000) { }
+    profiler.nsPerTick = (double)(ProfilerClock() - clockStart)/(double)(__rdtsc() - tscStart);
+    profiler.tscBase = tscStart;
+#endif
+
+    profiler.origin = ProfilerNow();
+
+    // Zone 0 is the frame itself
+    ProfilerZone("frame", false);
+
+#if !defined(PROFILER_NO_GPU)
+    for (int i = 0; i < PROFILER_GPU_LATENCY; i++)
+    {
+        glGenQueries(PROFILER_GPU_ZONES*2, profiler.gpuFrames[i].queries);
+    }
+#endif
+}
+
+void UnloadProfiler(void)
+{
+#if !defined(PROFILER_NO_GPU)
+    for (int i = 0; i < PROFILER_GPU_LATENCY; i++)
+    {
+        glDeleteQueries(PROFILER_GPU_ZONES*2, profiler.gpuFrames[i].queries);
+    }
+#endif
+    RL_FREE(profiler.events);
+    RL_FREE(profiler.gpuEvents);
+    RL_FREE(profiler.counterEvents);
+    profiler.events = NULL;
+    profiler.gpuEvents = NULL;
+    profiler.counterEvents = NULL;
+}
+
+void BeginProfileFrame(void)
+{
+    profiler.frame++;
+    profiler.depth = 0;
+    for (int i = 0; i < PROFILER_MAX_ZONES; i++)
+    {
+        profiler.history[i][profiler.frame % PROFILER_HISTORY] = 0.0f;
+        profiler.frameTicks[i] = 0;
+    }
+
+#if !defined(PROFILER_NO_GPU)
+    ProfileGpuFrame *slot = &profiler.gpuFrames[profiler.frame % PROFILER_GPU_LATENCY];
+    ProfilerResolveGpu(slot);
+    slot->frame = profiler.frame;
+    slot->offset = (long long)(ProfilerNow()*profiler.nsPerTick) - ProfilerGpuNow();
+#endif
+
+    profiler.frameStart = ProfilerNow();
+}
+
+void EndProfileFrame(void)
+{
+    while (profiler.depth > 0) EndProfileZone();
+
+    long long end = ProfilerNow();
+    ProfileEvent event = { 0, 0, profiler.frame, profiler.frameStart, end };
+    profiler.events[profiler.eventCount++ & (PROFILER_MAX_EVENTS - 1)] = event;
+    profiler.frameTicks[0] += end - profiler.frameStart;
+
+    for (int i = 0; i < profiler.zoneCount; i++)
+    {
+        profiler.history[i][profiler.frame % PROFILER_HISTORY] += (float)(profiler.frameTicks[i]*profiler.nsPerTick/1e6);
+    }
+}
+
+void BeginProfileZone(const char *name)
+{
+    if (profiler.depth == PROFILER_MAX_DEPTH) return;
+
+    profiler.stackZones[profiler.depth] = (unsigned short)ProfilerZone(name, false);
+    profiler.stackStarts[profiler.depth] = ProfilerNow();
+    profiler.depth++;
+}
+
+void EndProfileZone(void)
+{
+    if (profiler.depth == 0) return;
+
+    long long end = ProfilerNow();
+    profiler.depth--;
+    int zone = profiler.stackZones[profiler.depth];
+    long long start = profiler.stackStarts[profiler.depth];
+
+    ProfileEvent event = { (unsigned short)zone, (unsigned short)(profiler.depth + 1), profiler.frame, start, end };
+    profiler.events[profiler.eventCount++ & (PROFILER_MAX_EVENTS - 1)] = event;
+    profiler.frameTicks[zone] += end - start;
+}
+
+void BeginProfileGpuZone(const char *name)
+{
+#if !defined(PROFILER_NO_GPU)
+    ProfileGpuFrame *slot = &profiler.gpuFrames[profiler.frame % PROFILER_GPU_LATENCY];
+    if (profiler.gpuOpen >= 0 || slot->count == PROFILER_GPU_ZONES) return;
+
+    rlDrawRenderBatchActive();
+    profiler.gpuOpen = slot->count;
+    slot->zones[slot->count] = (unsigned short)ProfilerZone(name, true);
+    glQueryCounter(slot->queries[slot->count*2], GL_TIMESTAMP);
+#else
+    (void)name;
+#endif
+}
+
+void EndProfileGpuZone(void)
+{
+#if !defined(PROFILER_NO_GPU)
+    if (profiler.gpuOpen < 0) return;
+
+    ProfileGpuFrame *slot = &profiler.gpuFrames[profiler.frame % PROFILER_GPU_LATENCY];
+    rlDrawRenderBatchActive();
+    glQueryCounter(slot->queries[profiler.gpuOpen*2 + 1], GL_TIMESTAMP);
+    slot->count++;
+    profiler.gpuOpen = -1;
+#endif
+}
+
+static int ProfilerCounter(const char *name)
+{
+    for (int i = 0; i < profiler.counterCount; i++)
+    {
+        if (profiler.counterNames[i] == name || strcmp(profiler.counterNames[i], name) == 0) return i;
+    }
+    if (profiler.counterCount == PROFILER_MAX_COUNTERS) return -1;
+
+    profiler.counterNames[profiler.counterCount] = name;
+    return profiler.counterCount++;
+}
+
+void SetProfileCounter(const char *name, double value)
+{
+    int counter = ProfilerCounter(name);
+    if (counter < 0) return;
+
+    profiler.counterValues[counter] = value;
+    ProfileCounterEvent event = { (unsigned short)counter, profiler.frame, ProfilerNow(), value };
+    profiler.counterEvents[profiler.counterEventCount++ & (PROFILER_MAX_EVENTS - 1)] = event;
+}
+
+static int ProfilerCompareFloat(const void *a, const void *b)
+{
+    float fa = *(const float *)a, fb = *(const float *)b;
+    return (fa > fb) - (fa < fb);
+}
+
+void DrawProfiler(int posX, int posY)
+{
+    // Frames with complete data: GPU zones lag behind by the query latency
+    int frames = (int)profiler.frame;
+    if (frames > PROFILER_HISTORY - 1) frames = PROFILER_HISTORY - 1;
+
+    float sorted[PROFILER_HISTORY];
+    DrawRectangle(posX, posY, 420, 24 + (profiler.zoneCount + profiler.counterCount)*20, Fade(RAYWHITE, 0.8f));
+    DrawText("zone           p50     p95     p99 ms", posX + 4, posY + 2, 20, DARKGRAY);
+
+    for (int z = 0; z < profiler.zoneCount; z++)
+    {
+        int count = 0;
+        int skip = profiler.gpu[z] ? PROFILER_GPU_LATENCY : 0;
+        for (int i = 1 + skip; i <= frames; i++)
+        {
+            sorted[count++] = profiler.history[z][(profiler.frame - i) % PROFILER_HISTORY];
+        }
+        if (count == 0) continue;
+        qsort(sorted, count, sizeof(float), ProfilerCompareFloat);
+
+        DrawText(TextFormat("%-10s %s %7.2f %7.2f %7.2f", profiler.names[z], profiler.gpu[z] ? "gpu" : "cpu",
+            sorted[count*50/100], sorted[count*95/100], sorted[count*99/100]), posX + 4, posY + 22 + z*20, 20, BLACK);
+    }
+
+    for (int c = 0; c < profiler.counterCount; c++)
+    {
+        DrawText(TextFormat("%-18s %10.0f", profiler.counterNames[c], profiler.counterValues[c]),
+            posX + 4, posY + 22 + (profiler.zoneCount + c)*20, 20, DARKBLUE);
+    }
+}
+
+static void ProfilerWriteEvents(FILE *file, const ProfileEvent *events, unsigned int eventCount, int tid, long long origin)
+{
+    unsigned int count = (eventCount < PROFILER_MAX_EVENTS) ? eventCount : PROFILER_MAX_EVENTS;
+    for (unsigned int i = eventCount - count; i != eventCount; i++)
+    {
+        ProfileEvent e = events[i & (PROFILER_MAX_EVENTS - 1)];
+        fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d,\"args\":{\"frame\":%u}}",
+            profiler.names[e.zone], (tid == 1) ? "cpu" : "gpu", (e.start - origin)*profiler.nsPerTick/1e3, (e.end - e.start)*profiler.nsPerTick/1e3, tid, e.frame);
+    }
+}
+
+bool ExportProfileTrace(const char *fileName)
+{
+    FILE *file = fopen(fileName, "w");
+    if (file == NULL) return false;
+
+    // Track names first, every event after them starts with a comma
+    fprintf(file, "{\"traceEvents\":[");
+    fprintf(file, "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},");
+    fprintf(file, "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}");
+    ProfilerWriteEvents(file, profiler.events, profiler.eventCount, 1, profiler.origin);
+    ProfilerWriteEvents(file, profiler.gpuEvents, profiler.gpuEventCount, 2, profiler.origin);
+
+    unsigned int count = (profiler.counterEventCount < PROFILER_MAX_EVENTS) ? profiler.counterEventCount : PROFILER_MAX_EVENTS;
+    for (unsigned int i = profiler.counterEventCount - count; i != profiler.counterEventCount; i++)
+    {
+        ProfileCounterEvent e = profiler.counterEvents[i & (PROFILER_MAX_EVENTS - 1)];
+        fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"args\":{\"value\":%g}}",
+            profiler.counterNames[e.counter], (e.time - profiler.origin)*profiler.nsPerTick/1e3, e.value);
+    }
+    fprintf(file, "\n]}\n");
+
+    bool ok = (ferror(file) == 0);
+    fclose(file);
+    return ok;
+}
+
+#endif // PROFILER_IMPLEMENTATION
@@ -0,0 +1,281 @@
+/**********************************************************************************************
+*
+*   replay - Input recording and deterministic replay for repeatable performance runs
+*
+*   While recording, ReplayFrame appends one fixed size frame to the file: the down and
+*   pressed state of the keys the program registered and the camera after UpdateCamera.
+*   Frames are written as they happen, so a run that crashes keeps everything up to the crash.
+*
+*   While replaying, ReplayFrame puts the recorded camera back and IsReplayKeyDown and
+*   IsReplayKeyPressed answer from the file instead of the keyboard; the program skips
+*   UpdateCamera so the mouse does nothing. The demos advance their state once per frame and
+*   never read the frame time, so every frame is one fixed step and the replay runs with the
+*   frame rate uncapped: the same frames are simulated and drawn, only as fast as the machine
+*   allows. Once the last frame is used IsReplayFinished turns true, and UnloadReplay prints
+*   the frame time statistics of the run, for comparing builds on identical workloads.
+*
+*   Keys that were not registered (F2 for the trace export, say) go to the keyboard in both
+*   modes. A file only replays with the same key list it was recorded with.
+*
+*   CONFIGURATION:
+*
+*   #define REPLAY_IMPLEMENTATION
+*       Generates the implementation of the library into the included file.
+*       Only ONE file should hold the implementation.
+*
+**********************************************************************************************/
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "raylib.h"
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define REPLAY_MAX_KEYS     32          // Keys tracked per frame, one bit each
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct ReplayFrameData {
+    unsigned int down;          // Bit i: keys[i] held
+    unsigned int pressed;       // Bit i: keys[i] went down this frame
+    float position[3];          // Camera after the frame's update
+    float target[3];
+} ReplayFrameData;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+bool StartRecording(const char *fileName, const int *keys, int keyCount);   // Call after InitWindow
+bool StartReplay(const char *fileName, const int *keys, int keyCount);      // Loads the frames and uncaps the frame rate
+void UnloadReplay(void);                        // Closes the recording, prints the statistics of a replay
+void ReplayFrame(Camera3D *camera);             // Once per frame after the camera update: records it, or overwrites it when replaying
+bool IsReplaying(void);
+bool IsReplayFinished(void);                    // All recorded frames were used
+bool IsReplayKeyDown(int key);                  // IsKeyDown, from the file while replaying
+bool IsReplayKeyPressed(int key);               // IsKeyPressed, from the file while replaying
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // REPLAY_H
+
+/***********************************************************************************
+*
+*   REPLAY IMPLEMENTATION
+*
+************************************************************************************/
+
+#if defined(REPLAY_IMPLEMENTATION) && !defined(REPLAY_IMPLEMENTED)
+#define REPLAY_IMPLEMENTED
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REPLAY_MAGIC 0x31504c52         // "RPL1"
+
+static struct {
+    int mode;                           // 0: live, 1: recording, 2: replaying
+    int keyCount;
+    int keys[REPLAY_MAX_KEYS];
+
+    FILE *file;                         // Open while recording
+
+    ReplayFrameData *frames;            // Whole file while replaying
+    int frameCount;
+    int frame;                          // Next frame to play
+    unsigned int down;                  // Key state of the current frame
+    unsigned int pressed;
+
+    double lastTime;
+    float *frameTimes;                  // Seconds between consecutive replayed frames
+} replay = { 0 };
+
+static int ReplayKeyIndex(int key)
+{
+    for (int i = 0; i < replay.keyCount; i++)
+    {
+        if (replay.keys[i] == key) return i;
+    }
+    return -1;
+}
+
+static int ReplayCompareFloat(const void *a, const void *b)
+{
+    float fa = *(const float *)a, fb = *(const float *)b;
+    return (fa > fb) - (fa < fb);
+}
+
+static void ReplaySetKeys(const int *keys, int keyCount)
+{
+    replay.keyCount = (keyCount < REPLAY_MAX_KEYS) ? keyCount : REPLAY_MAX_KEYS;
+    memcpy(replay.keys, keys, replay.keyCount*sizeof(int));
+}
+
+bool StartRecording(const char *fileName, const int *keys, int keyCount)
+{
+    UnloadReplay();
+
+    replay.file = fopen(fileName, "wb");
+    if (replay.file == NULL)
+    {
+        TraceLog(LOG_WARNING, "REPLAY: [%s] Failed to open file for recording", fileName);
+        return false;
+    }
+
+    ReplaySetKeys(keys, keyCount);
+    unsigned int header[2] = { REPLAY_MAGIC, (unsigned int)replay.keyCount };
+    fwrite(header, sizeof(header), 1, replay.file);
+    fwrite(replay.keys, sizeof(int), replay.keyCount, replay.file);
+
+    replay.mode = 1;
+    TraceLog(LOG_INFO, "REPLAY: [%s] Recording", fileName);
+    return true;
+}
+
+bool StartReplay(const char *fileName, const int *keys, int keyCount)
+{
+    UnloadReplay();
+    ReplaySetKeys(keys, keyCount);
+
+    FILE *file = fopen(fileName, "rb");
+    if (file == NULL)
+    {
+        TraceLog(LOG_WARNING, "REPLAY: [%s] Failed to open file", fileName);
+        return false;
+    }
+
+    unsigned int header[2] = { 0 };
+    int recordedKeys[REPLAY_MAX_KEYS] = { 0 };
+    bool valid = (fread(header, sizeof(header), 1, file) == 1) && (header[0] == REPLAY_MAGIC) &&
+        ((int)header[1] == replay.keyCount) && (fread(recordedKeys, sizeof(int), replay.keyCount, file) == (size_t)replay.keyCount) &&
+        (memcmp(recordedKeys, replay.keys, replay.keyCount*sizeof(int)) == 0);
+
+    if (valid)
+    {
+        long start = ftell(file);
+        fseek(file, 0, SEEK_END);
+        replay.frameCount = (int)((ftell(file) - start)/(long)sizeof(ReplayFrameData));
+        fseek(file, start, SEEK_SET);
+
+        replay.frames = (ReplayFrameData *)RL_MALLOC((replay.frameCount + 1)*sizeof(ReplayFrameData));
+        replay.frameTimes = (float *)RL_MALLOC((replay.frameCount + 1)*sizeof(float));
+        replay.frameCount = (int)fread(replay.frames, sizeof(ReplayFrameData), replay.frameCount, file);
+    }
+    fclose(file);
+
+    if (!valid)
+    {
+        TraceLog(LOG_WARNING, "REPLAY: [%s] Not a recording of this program", fileName);
+        return false;
+    }
+
+    replay.mode = 2;
+    replay.frame = 0;
+    replay.lastTime = GetTime();
+    SetTargetFPS(0);
+    TraceLog(LOG_INFO, "REPLAY: [%s] Replaying %d frames", fileName, replay.frameCount);
+    return true;
+}
+
+void UnloadReplay(void)
+{
+    if (replay.file != NULL) fclose(replay.file);
+
+    // A frame's time runs from its ReplayFrame to the next one, the last one ends here
+    int count = replay.frame;
+    if ((replay.mode == 2) && (count > 0))
+    {
+        replay.frameTimes[count - 1] = (float)(GetTime() - replay.lastTime);
+
+        float *times = replay.frameTimes;
+        qsort(times, count, sizeof(float), ReplayCompareFloat);
+
+        double total = 0;
+        for (int i = 0; i < count; i++)
+        {
+            total += times[i];
+        }
+
+        TraceLog(LOG_INFO, "REPLAY: %d frames in %.3f s, %.1f fps", count, total, count/total);
+        TraceLog(LOG_INFO, "REPLAY: frame ms mean %.3f  min %.3f  p50 %.3f  p95 %.3f  p99 %.3f  max %.3f",
+            total*1e3/count, times[0]*1e3f, times[count/2]*1e3f, times[count*95/100]*1e3f, times[count*99/100]*1e3f, times[count - 1]*1e3f);
+    }
+
+    RL_FREE(replay.frames);
+    RL_FREE(replay.frameTimes);
+    memset(&replay, 0, sizeof(replay));
+}
+
+void ReplayFrame(Camera3D *camera)
+{
+    if (replay.mode == 1)
+    {
+        ReplayFrameData data = {
+            0, 0,
+            { camera->position.x, camera->position.y, camera->position.z },
+            { camera->target.x, camera->target.y, camera->target.z }
+        };
+        for (int i = 0; i < replay.keyCount; i++)
+        {
+            if (IsKeyDown(replay.keys[i])) data.down |= 1u << i;
+            if (IsKeyPressed(replay.keys[i])) data.pressed |= 1u << i;
+        }
+        fwrite(&data, sizeof(data), 1, replay.file);
+    }
+    else if (replay.mode == 2)
+    {
+        double now = GetTime();
+        if (replay.frame > 0) replay.frameTimes[replay.frame - 1] = (float)(now - replay.lastTime);
+        replay.lastTime = now;
+
+        if (replay.frame < replay.frameCount)
+        {
+            ReplayFrameData data = replay.frames[replay.frame];
+            replay.down = data.down;
+            replay.pressed = data.pressed;
+            camera->position = (Vector3){ data.position[0], data.position[1], data.position[2] };
+            camera->target = (Vector3){ data.target[0], data.target[1], data.target[2] };
+            replay.frame++;
+        }
+        else
+        {
+            replay.down = 0;
+            replay.pressed = 0;
+        }
+    }
+}
+
+bool IsReplaying(void)
+{
+    return replay.mode == 2;
+}
+
+bool IsReplayFinished(void)
+{
+    return (replay.mode == 2) && (replay.frame >= replay.frameCount);
+}
+
+bool IsReplayKeyDown(int key)
+{
+    int i = ReplayKeyIndex(key);
+    if ((replay.mode != 2) || (i < 0)) return IsKeyDown(key);
+    return (replay.down >> i) & 1;
+}
+
+bool IsReplayKeyPressed(int key)
+{
+    int i = ReplayKeyIndex(key);
+    if ((replay.mode != 2) || (i < 0)) return IsKeyPressed(key);
+    return (replay.pressed >> i) & 1;
+}
+
+#endif // REPLAY_IMPLEMENTATION
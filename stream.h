@@ -0,0 +1,948 @@
+/**********************************************************************************************
+*
+*   stream - World files: compressed chunks, streaming from disk and snapshot saves
+*
+*   A world file holds the SaveChunkData payload (palette plus RLE or bit-packed indices,
+*   see world.h) of every non-uniform chunk and an index table to find them:
+*
+*       StreamFileHeader
+*       payloads            entry.bytes at entry.offset, none for uniform chunks
+*       StreamChunkEntry    index[chunkCount] at header.indexOffset (WorldIndex order)
+*
+*   The index goes last so a save can append: new payloads and a new index are added at the
+*   end, and only then does the header switch indexOffset over. A save that dies half way
+*   leaves the previous index in charge. What is no longer referenced counts as garbage,
+*   once it is half the file the next save writes a fresh copy instead.
+*
+*   Files are memory mapped (read whole on Windows) and decoded one chunk at a time:
+*
+*     - LoadWorldFile decodes every chunk right away.
+*     - LoadWorldStream sizes the World from the index and fills in what it already says:
+*       uniform chunks (all air, all stone) are complete right away and never stream, the
+*       others start out unknown (Chunk.unknown). A background I/O thread decodes those
+*       straight from the mapping on demand, so the page faults land on it as well.
+*
+*   UpdateWorldStream runs once per frame on the thread that owns the World:
+*
+*     - Installs the chunks the I/O thread finished since the last call. Only this thread
+*       ever writes the World, the I/O thread decodes into chunks of its own.
+*     - Wants every streamed chunk within 'radius' chunks of the camera and of the point the
+*       camera reaches in STREAM_PREFETCH_FRAMES frames at its current speed (capped to the
+*       radius), so loads run ahead along the direction of travel.
+*     - Wanted chunks already in memory count as hits and move to the front of the LRU list,
+*       the rest count as misses and are requested nearest first, at most STREAM_QUEUE_SIZE
+*       in flight. Requests that are not picked up by the next update are replaced.
+*     - Keeps the resident chunks under the byte budget, evicting from the back of the LRU
+*       list. Chunks wanted this frame are never evicted; once the wanted set alone fills the
+*       budget, nothing more is requested.
+*
+*   Nothing waits for the disk: until a chunk arrives it reads as empty and the dda.h kernels
+*   stop at it with RayHit.unknown. Edits are only safe on resident chunks and are dropped
+*   when the chunk is evicted.
+*
+*   SaveWorldSnapshot copies what has to be written and hands it to a background thread,
+*   the frame only pays for the copy. Chunks the file the world came from (or was last
+*   saved to) already holds are not copied, their payloads are reused from that file:
+*
+*     - Saving again to that file appends the dirty chunks (Chunk.dirty) only.
+*     - Saving anywhere else writes a whole file, dirty chunks encoded from the copies and
+*       the rest copied over from the base file.
+*     - A streamed world keeps its stream file as the base, so unknown chunks are carried
+*       over and dirty stays set (it means "differs from the stream file"). Saving over the
+*       file being streamed is refused.
+*
+*   Only one save runs at a time, one asked for meanwhile is skipped. Whole files are
+*   written next to the target and renamed over it once complete.
+*
+*   All values are in host byte order, the file is for the machine that wrote it.
+*
+*   CONFIGURATION:
+*
+*   #define STREAM_IMPLEMENTATION
+*       Generates the implementation of the library into the included file.
+*       Only ONE file should hold the implementation.
+*
+**********************************************************************************************/
+
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "raylib.h"
+#include "world.h"
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define STREAM_FILE_MAGIC       0x4d525453      // "STRM"
+#define STREAM_FILE_VERSION     2
+#define STREAM_QUEUE_SIZE       64              // Chunk loads in flight at most
+#define STREAM_PREFETCH_FRAMES  30              // Frames of camera motion to load ahead
+#define STREAM_MAX_RADIUS       32              // Chunks
+#define STREAM_PATH_MAX         512             // World file names, including the terminator
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct StreamFileHeader {
+    unsigned int magic;
+    unsigned int version;
+    int size;                   // World.size
+    int chunkCount;
+    uint64_t indexOffset;       // Position of the index, the last thing in the file
+    uint64_t garbage;           // Bytes of replaced payloads and indices
+} StreamFileHeader;
+
+typedef struct StreamChunkEntry {
+    uint64_t offset;            // Payload position in the file
+    unsigned int bytes;         // Payload size, 0 for a uniform chunk
+    int value;                  // Value of a uniform chunk
+    int bits;                   // Chunk.bits once the payload is loaded
+} StreamChunkEntry;
+
+typedef struct WorldStreamStats {
+    int streamed;               // Non-uniform chunks in the file
+    int resident;               // Of those, in memory
+    int pending;                // Requested and not installed yet
+    size_t residentBytes;       // ChunkMemoryUsage of the resident ones
+    size_t budget;
+    long long hits;             // Wanted chunks found resident, counted every update
+    long long misses;           // Wanted chunks that were not
+    long long loads;
+    long long evictions;
+} WorldStreamStats;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+bool ExportWorldStream(const World *world, const char *fileName);       // Write a whole world file now, on this thread
+bool LoadWorldFile(World *world, const char *fileName);                 // (Re)init world from the file, every chunk decoded
+bool LoadWorldStream(World *world, const char *fileName, size_t budget, int radius);  // (Re)init world from the file, streamed chunks unknown, start the I/O thread
+void UnloadWorldStream(void);                                           // Stop the I/O thread, the world keeps what is resident
+void UpdateWorldStream(World *world, Camera3D camera);                  // Once per frame: install, request, evict
+WorldStreamStats GetWorldStreamStats(void);
+bool SaveWorldSnapshot(World *world, const char *fileName);             // Copy what changed and write it in the background, false if not started
+bool IsWorldSaving(void);                                               // A save is still being written
+bool WaitWorldSave(void);                                               // Finish the save in flight, true if the last save succeeded
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STREAM_H
+
+/***********************************************************************************
+*
+*   STREAM IMPLEMENTATION
+*
+************************************************************************************/
+
+#if defined(STREAM_IMPLEMENTATION) && !defined(STREAM_IMPLEMENTED)
+#define STREAM_IMPLEMENTED
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+enum {
+    STREAM_UNIFORM = 0,         // Complete from the index, never streamed
+    STREAM_UNKNOWN,
+    STREAM_QUEUED,              // Requested, loading or loaded but not installed
+    STREAM_RESIDENT,
+};
+
+// Contents of a world file, mapped or a heap copy
+typedef struct StreamMapping {
+    unsigned char *data;
+    size_t size;
+    bool mapped;
+} StreamMapping;
+
+typedef struct StreamLoad {
+    int index;
+    bool ok;
+    Chunk chunk;
+} StreamLoad;
+
+typedef struct StreamCandidate {
+    int index;
+    float distance;             // From the camera
+} StreamCandidate;
+
+typedef struct StreamSaveItem {
+    int index;                  // Chunk
+    bool copied;                // chunk holds a copy to encode, otherwise the base payload is reused
+    Chunk chunk;
+} StreamSaveItem;
+
+typedef struct StreamSaveJob {
+    char fileName[STREAM_PATH_MAX];
+    int size;                   // World.size
+    int chunkCount;
+    bool append;                // Add to the end of the base rather than write a whole file
+    bool streamed;              // The base is the file being streamed
+    StreamSaveItem *items;      // Every chunk for a whole file, the dirty ones when appending
+    int itemCount;
+    StreamFileHeader header;    // Of the file once written
+} StreamSaveJob;
+
+static struct {
+    bool active;
+    char fileName[STREAM_PATH_MAX];
+    StreamMapping file;         // Only read once the I/O thread runs
+    int chunkCount;
+    int chunksPerSide;
+    StreamChunkEntry *entries;
+
+    unsigned char *state;
+    int *bytes;                 // Memory of a resident chunk, the estimate while queued
+    unsigned int *wanted;       // Last update that wanted the chunk
+    int *prev, *next;           // LRU list of resident chunks, head used most recently
+    int head, tail;
+    unsigned int update;
+    StreamCandidate *candidates;
+
+    size_t budget;
+    int radius;
+    Vector3 lastPosition;
+    bool moved;                 // lastPosition is valid
+    WorldStreamStats stats;
+
+    // Shared with the I/O thread, under lock
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;        // New requests, room for results, or quit
+    int requests[STREAM_QUEUE_SIZE];
+    int requestHead, requestCount;
+    StreamLoad done[STREAM_QUEUE_SIZE];
+    int doneCount;
+    int loading;                // Chunk being read, -1 for none
+    bool quit;
+} stream = { 0 };
+
+static struct {
+    pthread_t thread;
+    bool running;               // Started and not joined yet
+    int finished;               // Set by the save thread once done, atomic
+    bool ok;                    // Outcome of the last save
+    StreamSaveJob job;
+
+    // Owned by the save thread while one runs
+    char base[STREAM_PATH_MAX]; // File the clean chunks match, "" for none
+    StreamFileHeader header;    // Of the base
+} save = { 0 };
+
+static bool StreamFileOpen(const char *fileName, StreamMapping *file)
+{
+    *file = (StreamMapping){ 0 };
+
+#if defined(_WIN32)
+    // No mmap here: one read into a single buffer, chunks still decode lazily from it
+    FILE *f = fopen(fileName, "rb");
+    if (!f) return false;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    file->data = (unsigned char *)RL_MALLOC(size > 0 ? size : 1);
+    file->size = (size_t)size;
+    bool ok = size > 0 && fread(file->data, 1, file->size, f) == file->size;
+    fclose(f);
+    if (!ok)
+    {
+        RL_FREE(file->data);
+        *file = (StreamMapping){ 0 };
+    }
+    return ok;
+#else
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return false;
+
+    file->data = (unsigned char *)data;
+    file->size = (size_t)st.st_size;
+    file->mapped = true;
+    return true;
+#endif
+}
+
+static void StreamFileClose(StreamMapping *file)
+{
+#if !defined(_WIN32)
+    if (file->mapped)
+    {
+        munmap(file->data, file->size);
+        *file = (StreamMapping){ 0 };
+        return;
+    }
+#endif
+    RL_FREE(file->data);
+    *file = (StreamMapping){ 0 };
+}
+
+// Copy of the index of a mapped world file, NULL when it isn't a valid one
+static StreamChunkEntry *StreamReadIndex(const StreamMapping *file, StreamFileHeader *header)
+{
+    if (file->size < sizeof(StreamFileHeader)) return NULL;
+    memcpy(header, file->data, sizeof(StreamFileHeader));
+
+    bool valid = (header->magic == STREAM_FILE_MAGIC) && (header->version == STREAM_FILE_VERSION) &&
+        (header->size >= 1) && (header->size <= WORLD_MAX_SIZE);
+    int n = valid ? (header->size + CHUNK_SIZE - 1)/CHUNK_SIZE : 0;
+    valid = valid && (header->chunkCount == n*n*n) && (header->indexOffset >= sizeof(StreamFileHeader)) &&
+        (header->indexOffset <= file->size) && ((file->size - header->indexOffset)/sizeof(StreamChunkEntry) >= (size_t)header->chunkCount);
+    if (!valid) return NULL;
+
+    StreamChunkEntry *entries = (StreamChunkEntry *)RL_MALLOC(header->chunkCount*sizeof(StreamChunkEntry));
+    memcpy(entries, file->data + header->indexOffset, header->chunkCount*sizeof(StreamChunkEntry));
+    for (int i = 0; i < header->chunkCount; i++)
+    {
+        StreamChunkEntry e = entries[i];
+        if (e.bytes == 0) continue;
+        // Compared without adding, a crafted offset near 2^64 must not wrap past the check
+        if (e.offset < sizeof(StreamFileHeader) || e.offset > header->indexOffset || e.bytes > header->indexOffset - e.offset ||
+            (e.bits != 1 && e.bits != 2 && e.bits != 4 && e.bits != 8 && e.bits != 16))
+        {
+            RL_FREE(entries);
+            return NULL;
+        }
+    }
+    return entries;
+}
+
+static void *StreamWorker(void *arg)
+{
+    (void)arg;
+
+    pthread_mutex_lock(&stream.lock);
+    while (true)
+    {
+        while (!stream.quit && (stream.requestHead == stream.requestCount || stream.doneCount == STREAM_QUEUE_SIZE))
+        {
+            pthread_cond_wait(&stream.wake, &stream.lock);
+        }
+        if (stream.quit) break;
+
+        int i = stream.requests[stream.requestHead++];
+        stream.loading = i;
+        pthread_mutex_unlock(&stream.lock);
+
+        StreamChunkEntry entry = stream.entries[i];
+        StreamLoad load = { i, false, { 0 } };
+        load.ok = LoadChunkData(&load.chunk, stream.file.data + entry.offset, entry.bytes);
+
+        pthread_mutex_lock(&stream.lock);
+        stream.done[stream.doneCount++] = load;
+        stream.loading = -1;
+    }
+    pthread_mutex_unlock(&stream.lock);
+    return NULL;
+}
+
+static void StreamUnlink(int i)
+{
+    if (stream.prev[i] >= 0) stream.next[stream.prev[i]] = stream.next[i];
+    else stream.head = stream.next[i];
+    if (stream.next[i] >= 0) stream.prev[stream.next[i]] = stream.prev[i];
+    else stream.tail = stream.prev[i];
+}
+
+static void StreamPushFront(int i)
+{
+    stream.prev[i] = -1;
+    stream.next[i] = stream.head;
+    if (stream.head >= 0) stream.prev[stream.head] = i;
+    else stream.tail = i;
+    stream.head = i;
+}
+
+static void StreamEvict(World *world, int i)
+{
+    StreamUnlink(i);
+    UnloadChunkData(&world->chunks[i], 0);
+    world->chunks[i].unknown = true;
+    stream.state[i] = STREAM_UNKNOWN;
+    stream.stats.residentBytes -= stream.bytes[i];
+    stream.stats.resident--;
+    stream.stats.evictions++;
+}
+
+// Evict unwanted chunks from the back until 'bytes' more fit, false if they can't
+static bool StreamMakeRoom(World *world, size_t bytes, size_t reserved)
+{
+    while (stream.stats.residentBytes + reserved + bytes > stream.budget)
+    {
+        int i = stream.tail;
+        if ((i < 0) || (stream.wanted[i] == stream.update)) return false;
+        StreamEvict(world, i);
+    }
+    return true;
+}
+
+static int StreamCompareCandidate(const void *a, const void *b)
+{
+    float da = ((const StreamCandidate *)a)->distance, db = ((const StreamCandidate *)b)->distance;
+    return (da > db) - (da < db);
+}
+
+// Add the streamed chunks within the radius of center to the candidates
+static int StreamGather(Vector3 center, Vector3 eye, int count)
+{
+    int n = stream.chunksPerSide;
+    int r = stream.radius;
+    int c[3] = { (int)floorf(center.x) >> CHUNK_BITS, (int)floorf(center.y) >> CHUNK_BITS, (int)floorf(center.z) >> CHUNK_BITS };
+
+    for (int z = c[2] - r; z <= c[2] + r; z++)
+    {
+        for (int y = c[1] - r; y <= c[1] + r; y++)
+        {
+            for (int x = c[0] - r; x <= c[0] + r; x++)
+            {
+                if (x < 0 || y < 0 || z < 0 || x >= n || y >= n || z >= n) continue;
+                if ((x - c[0])*(x - c[0]) + (y - c[1])*(y - c[1]) + (z - c[2])*(z - c[2]) > r*r) continue;
+
+                int i = (z*n + y)*n + x;
+                if ((stream.state[i] == STREAM_UNIFORM) || (stream.wanted[i] == stream.update)) continue;
+                stream.wanted[i] = stream.update;
+
+                Vector3 middle = { (x + 0.5f)*CHUNK_SIZE, (y + 0.5f)*CHUNK_SIZE, (z + 0.5f)*CHUNK_SIZE };
+                float dx = middle.x - eye.x, dy = middle.y - eye.y, dz = middle.z - eye.z;
+                stream.candidates[count++] = (StreamCandidate){ i, sqrtf(dx*dx + dy*dy + dz*dz) };
+            }
+        }
+    }
+    return count;
+}
+
+// Write the items of a job: a whole file next to the target and renamed over it, or
+// appended to the base. Reused payloads are copied straight out of the base mapping
+static bool StreamWriteFile(StreamSaveJob *job, const char *base)
+{
+    int count = job->chunkCount;
+    bool reuse = job->append;
+    for (int k = 0; k < job->itemCount; k++)
+    {
+        if (!job->items[k].copied) reuse = true;
+    }
+
+    StreamMapping baseFile = { 0 };
+    StreamChunkEntry *baseIndex = NULL;
+    StreamFileHeader header = { .magic = STREAM_FILE_MAGIC, .version = STREAM_FILE_VERSION, .size = job->size, .chunkCount = count };
+    if (job->streamed)
+    {
+        baseFile = stream.file;
+        baseIndex = stream.entries;
+    }
+    else if (reuse)
+    {
+        StreamFileHeader baseHeader = { 0 };
+        if (StreamFileOpen(base, &baseFile)) baseIndex = StreamReadIndex(&baseFile, &baseHeader);
+        if ((baseIndex == NULL) || (baseHeader.chunkCount != count) || (job->append && (baseHeader.indexOffset != save.header.indexOffset)))
+        {
+            TraceLog(LOG_WARNING, "STREAM: [%s] Changed or unreadable, can't take unchanged chunks from it", base);
+            RL_FREE(baseIndex);
+            if (baseFile.data) StreamFileClose(&baseFile);
+            return false;
+        }
+        if (job->append) header = baseHeader;
+    }
+
+    StreamChunkEntry *entries = (StreamChunkEntry *)RL_CALLOC(count, sizeof(StreamChunkEntry));
+    if (job->append) memcpy(entries, baseIndex, count*sizeof(StreamChunkEntry));
+
+    char path[STREAM_PATH_MAX + 4];
+    snprintf(path, sizeof(path), job->append ? "%s" : "%s.tmp", job->fileName);
+    FILE *file = fopen(path, job->append ? "r+b" : "wb");
+    uint64_t offset = sizeof(header);
+    bool ok = (file != NULL);
+    if (ok && job->append)
+    {
+        // Appends go after whatever the file ends with, including what a failed earlier
+        // append left behind the index: nothing references those bytes, they are garbage
+        long end = (fseek(file, 0, SEEK_END) == 0) ? ftell(file) : -1;
+        uint64_t used = header.indexOffset + count*sizeof(StreamChunkEntry);
+        ok = (end >= 0) && ((uint64_t)end >= used);
+        if (ok)
+        {
+            offset = (uint64_t)end;
+            header.garbage += offset - used;
+        }
+    }
+    else if (ok) ok = (fwrite(&header, sizeof(header), 1, file) == 1);
+
+    unsigned char *buffer = (unsigned char *)RL_MALLOC(CHUNK_DATA_MAX_SIZE);
+    for (int k = 0; k < job->itemCount && ok; k++)
+    {
+        StreamSaveItem *item = &job->items[k];
+        StreamChunkEntry entry = { 0 };
+        const unsigned char *payload = NULL;
+        if (job->append) header.garbage += entries[item->index].bytes;
+
+        if (item->copied)
+        {
+            entry.value = item->chunk.value;
+            if (item->chunk.bits != 0)
+            {
+                ChunkDataHeader chunkHeader;
+                entry.bytes = (unsigned int)SaveChunkData(&item->chunk, buffer);
+                memcpy(&chunkHeader, buffer, sizeof(chunkHeader));
+                entry.bits = chunkHeader.bits;
+                payload = buffer;
+            }
+        }
+        else
+        {
+            entry = baseIndex[item->index];
+            payload = baseFile.data + entry.offset;
+        }
+
+        if (entry.bytes)
+        {
+            entry.offset = offset;
+            offset += entry.bytes;
+            ok = (fwrite(payload, 1, entry.bytes, file) == entry.bytes);
+        }
+        entries[item->index] = entry;
+    }
+    RL_FREE(buffer);
+
+    // The header goes last, until then the file still describes the previous save
+    if (job->append) header.garbage += count*sizeof(StreamChunkEntry);
+    header.indexOffset = offset;
+    if (ok) ok = (fwrite(entries, sizeof(StreamChunkEntry), count, file) == (size_t)count) && (fflush(file) == 0);
+    if (ok) ok = (fseek(file, 0, SEEK_SET) == 0) && (fwrite(&header, sizeof(header), 1, file) == 1);
+    if (file && fclose(file) != 0) ok = false;
+
+    if (!job->append)
+    {
+#if defined(_WIN32)
+        if (ok) remove(job->fileName);
+#endif
+        if (ok) ok = (rename(path, job->fileName) == 0);
+        else remove(path);
+    }
+
+    if (!job->streamed && baseFile.data)
+    {
+        RL_FREE(baseIndex);
+        StreamFileClose(&baseFile);
+    }
+    RL_FREE(entries);
+
+    if (!ok) TraceLog(LOG_WARNING, "STREAM: [%s] Failed to write world file", job->fileName);
+    job->header = header;
+    return ok;
+}
+
+static void *StreamSaveWorker(void *arg)
+{
+    (void)arg;
+    StreamSaveJob *job = &save.job;
+    save.ok = StreamWriteFile(job, save.base);
+
+    int written = 0;
+    for (int k = 0; k < job->itemCount; k++)
+    {
+        if (job->items[k].copied) written++;
+        UnloadChunkData(&job->items[k].chunk, 0);
+    }
+    if (save.ok)
+    {
+        TraceLog(LOG_INFO, "STREAM: [%s] Saved %d chunks (%s), file %llu KB, %llu KB of it garbage", job->fileName, written,
+            job->append ? "appended" : "whole file", (unsigned long long)(job->header.indexOffset/1024), (unsigned long long)(job->header.garbage/1024));
+    }
+
+    // A streamed world stays relative to its stream file, others now match what was written.
+    // After a failure nothing is known to match, the next save copies every chunk
+    if (!job->streamed)
+    {
+        if (save.ok) memcpy(save.base, job->fileName, sizeof(save.base));
+        else save.base[0] = '\0';
+        save.header = job->header;
+    }
+
+    __atomic_store_n(&save.finished, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+bool ExportWorldStream(const World *world, const char *fileName)
+{
+    WaitWorldSave();
+    if (strlen(fileName) >= STREAM_PATH_MAX)
+    {
+        TraceLog(LOG_WARNING, "STREAM: [%s] File name too long", fileName);
+        return false;
+    }
+
+    // Every chunk encoded from the world itself, nothing taken from a base
+    StreamSaveJob job = { .size = world->size, .chunkCount = world->chunksPerSide*world->chunksPerSide*world->chunksPerSide };
+    strcpy(job.fileName, fileName);
+    job.items = (StreamSaveItem *)RL_MALLOC(job.chunkCount*sizeof(StreamSaveItem));
+    for (int i = 0; i < job.chunkCount; i++)
+    {
+        job.items[i] = (StreamSaveItem){ i, true, world->chunks[i] };
+    }
+    job.itemCount = job.chunkCount;
+
+    bool ok = StreamWriteFile(&job, "");
+    RL_FREE(job.items);
+
+    // Replaced the base, whose index the next save would have appended to
+    if (strcmp(fileName, save.base) == 0) save.base[0] = '\0';
+    return ok;
+}
+
+bool LoadWorldFile(World *world, const char *fileName)
+{
+    UnloadWorldStream();
+    WaitWorldSave();
+
+    StreamMapping file = { 0 };
+    StreamFileHeader header = { 0 };
+    StreamChunkEntry *entries = NULL;
+    if ((strlen(fileName) < STREAM_PATH_MAX) && StreamFileOpen(fileName, &file)) entries = StreamReadIndex(&file, &header);
+    if (entries == NULL)
+    {
+        TraceLog(LOG_WARNING, "STREAM: [%s] Not a world file", fileName);
+        if (file.data) StreamFileClose(&file);
+        return false;
+    }
+
+    if (world->chunks) UnloadWorld(world);
+    InitWorld(world, header.size);
+
+    int failed = 0;
+    for (int i = 0; i < header.chunkCount; i++)
+    {
+        Chunk *chunk = &world->chunks[i];
+        if (entries[i].bytes == 0) *chunk = (Chunk){ .value = entries[i].value, .changed = true, .bricks = entries[i].value ? ~0ull : 0 };
+        else if (!LoadChunkData(chunk, file.data + entries[i].offset, entries[i].bytes)) failed++;
+    }
+    if (failed) TraceLog(LOG_WARNING, "STREAM: [%s] %d chunks unreadable, left empty", fileName, failed);
+
+    // Saving back to it only appends what changes from now on
+    strcpy(save.base, fileName);
+    save.header = header;
+
+    RL_FREE(entries);
+    StreamFileClose(&file);
+    return true;
+}
+
+bool LoadWorldStream(World *world, const char *fileName, size_t budget, int radius)
+{
+    UnloadWorldStream();
+    WaitWorldSave();
+
+    StreamMapping file = { 0 };
+    StreamFileHeader header = { 0 };
+    StreamChunkEntry *entries = NULL;
+    if ((strlen(fileName) < STREAM_PATH_MAX) && StreamFileOpen(fileName, &file)) entries = StreamReadIndex(&file, &header);
+    if (entries == NULL)
+    {
+        TraceLog(LOG_WARNING, "STREAM: [%s] Not a world file", fileName);
+        if (file.data) StreamFileClose(&file);
+        return false;
+    }
+
+    if (world->chunks) UnloadWorld(world);
+    InitWorld(world, header.size);
+
+    int count = header.chunkCount;
+    strcpy(stream.fileName, fileName);
+    stream.file = file;
+    stream.chunkCount = count;
+    stream.chunksPerSide = world->chunksPerSide;
+    stream.entries = entries;
+    stream.state = (unsigned char *)RL_CALLOC(count, 1);
+    stream.bytes = (int *)RL_CALLOC(count, sizeof(int));
+    stream.wanted = (unsigned int *)RL_CALLOC(count, sizeof(unsigned int));
+    stream.prev = (int *)RL_MALLOC(count*sizeof(int));
+    stream.next = (int *)RL_MALLOC(count*sizeof(int));
+    stream.head = -1;
+    stream.tail = -1;
+    stream.update = 0;
+    stream.budget = budget;
+    stream.radius = (radius < 1) ? 1 : (radius > STREAM_MAX_RADIUS ? STREAM_MAX_RADIUS : radius);
+    int side = 2*stream.radius + 1;
+    stream.candidates = (StreamCandidate *)RL_MALLOC(2*side*side*side*sizeof(StreamCandidate));
+    stream.moved = false;
+    stream.stats = (WorldStreamStats){ .budget = budget };
+
+    for (int i = 0; i < count; i++)
+    {
+        Chunk *chunk = &world->chunks[i];
+        if (entries[i].bytes == 0)
+        {
+            *chunk = (Chunk){ .value = entries[i].value, .changed = true, .bricks = entries[i].value ? ~0ull : 0 };
+            continue;
+        }
+        chunk->unknown = true;
+        stream.state[i] = STREAM_UNKNOWN;
+        stream.stats.streamed++;
+    }
+
+    // Saves take every chunk that isn't dirty from the stream file
+    strcpy(save.base, fileName);
+    save.header = header;
+
+    stream.requestHead = 0;
+    stream.requestCount = 0;
+    stream.doneCount = 0;
+    stream.loading = -1;
+    stream.quit = false;
+    pthread_mutex_init(&stream.lock, NULL);
+    pthread_cond_init(&stream.wake, NULL);
+    pthread_create(&stream.thread, NULL, StreamWorker, NULL);
+    stream.active = true;
+
+    TraceLog(LOG_INFO, "STREAM: [%s] %d^3 world, %d of %d chunks streamed, budget %zu KB", fileName,
+        header.size, stream.stats.streamed, count, budget/1024);
+    return true;
+}
+
+void UnloadWorldStream(void)
+{
+    if (!stream.active) return;
+
+    // A save may still be copying payloads out of the mapping
+    WaitWorldSave();
+    save.base[0] = '\0';
+
+    pthread_mutex_lock(&stream.lock);
+    stream.quit = true;
+    pthread_cond_broadcast(&stream.wake);
+    pthread_mutex_unlock(&stream.lock);
+    pthread_join(stream.thread, NULL);
+    pthread_cond_destroy(&stream.wake);
+    pthread_mutex_destroy(&stream.lock);
+
+    for (int i = 0; i < stream.doneCount; i++)
+    {
+        UnloadChunkData(&stream.done[i].chunk, 0);
+    }
+
+    StreamFileClose(&stream.file);
+    RL_FREE(stream.entries);
+    RL_FREE(stream.state);
+    RL_FREE(stream.bytes);
+    RL_FREE(stream.wanted);
+    RL_FREE(stream.prev);
+    RL_FREE(stream.next);
+    RL_FREE(stream.candidates);
+    memset(&stream, 0, sizeof(stream));
+}
+
+void UpdateWorldStream(World *world, Camera3D camera)
+{
+    if (!stream.active) return;
+    stream.update++;
+
+    // Take what the I/O thread finished and drop the requests it hasn't started
+    StreamLoad done[STREAM_QUEUE_SIZE];
+    pthread_mutex_lock(&stream.lock);
+    int doneCount = stream.doneCount;
+    memcpy(done, stream.done, doneCount*sizeof(StreamLoad));
+    stream.doneCount = 0;
+    for (int r = stream.requestHead; r < stream.requestCount; r++)
+    {
+        stream.state[stream.requests[r]] = STREAM_UNKNOWN;
+    }
+    stream.requestHead = 0;
+    stream.requestCount = 0;
+    int loading = stream.loading;
+    pthread_mutex_unlock(&stream.lock);
+
+    for (int d = 0; d < doneCount; d++)
+    {
+        int i = done[d].index;
+        Chunk *chunk = &world->chunks[i];
+        if (!done[d].ok)
+        {
+            // Unreadable: leave it empty for good rather than asking again every frame
+            TraceLog(LOG_WARNING, "STREAM: Failed to load chunk %d, treating it as empty", i);
+            chunk->unknown = false;
+            chunk->changed = true;
+            stream.state[i] = STREAM_UNIFORM;
+            stream.stats.streamed--;
+            continue;
+        }
+
+        UnloadChunkData(chunk, 0);
+        *chunk = done[d].chunk;
+        stream.state[i] = STREAM_RESIDENT;
+        stream.bytes[i] = (int)ChunkMemoryUsage(chunk);
+        stream.stats.residentBytes += stream.bytes[i];
+        stream.stats.resident++;
+        stream.stats.loads++;
+        StreamPushFront(i);
+    }
+
+    // Wanted: around the camera, and around where it is headed
+    Vector3 eye = camera.position;
+    Vector3 ahead = eye;
+    if (stream.moved)
+    {
+        float reach = (float)(stream.radius*CHUNK_SIZE);
+        Vector3 motion = { (eye.x - stream.lastPosition.x)*STREAM_PREFETCH_FRAMES, (eye.y - stream.lastPosition.y)*STREAM_PREFETCH_FRAMES,
+            (eye.z - stream.lastPosition.z)*STREAM_PREFETCH_FRAMES };
+        float length = sqrtf(motion.x*motion.x + motion.y*motion.y + motion.z*motion.z);
+        float scale = (length > reach) ? reach/length : 1.0f;
+        ahead = (Vector3){ eye.x + motion.x*scale, eye.y + motion.y*scale, eye.z + motion.z*scale };
+    }
+    stream.lastPosition = eye;
+    stream.moved = true;
+
+    int count = StreamGather(eye, eye, 0);
+    count = StreamGather(ahead, eye, count);
+    qsort(stream.candidates, count, sizeof(StreamCandidate), StreamCompareCandidate);
+
+    // Hits go to the front of the LRU list first, so making room below never evicts them
+    for (int c = 0; c < count; c++)
+    {
+        int i = stream.candidates[c].index;
+        if (stream.state[i] != STREAM_RESIDENT) continue;
+
+        // Edits may have grown or collapsed the chunk since it was loaded
+        int bytes = (int)ChunkMemoryUsage(&world->chunks[i]);
+        stream.stats.residentBytes += bytes - stream.bytes[i];
+        stream.bytes[i] = bytes;
+        StreamUnlink(i);
+        StreamPushFront(i);
+        stream.stats.hits++;
+    }
+
+    // Memory the chunks in flight will take once installed
+    size_t reserved = (loading >= 0 && stream.state[loading] == STREAM_QUEUED) ? stream.bytes[loading] : 0;
+    int pending = (loading >= 0 && stream.state[loading] == STREAM_QUEUED) ? 1 : 0;
+    bool full = !StreamMakeRoom(world, 0, reserved);
+
+    int requests[STREAM_QUEUE_SIZE];
+    int requestCount = 0;
+    for (int c = 0; c < count; c++)
+    {
+        int i = stream.candidates[c].index;
+        if (stream.state[i] == STREAM_RESIDENT) continue;
+        stream.stats.misses++;
+        if (stream.state[i] != STREAM_UNKNOWN || full || pending + requestCount == STREAM_QUEUE_SIZE) continue;
+
+        Chunk estimate = { .bits = stream.entries[i].bits };
+        size_t bytes = ChunkMemoryUsage(&estimate);
+        if (!StreamMakeRoom(world, bytes, reserved))
+        {
+            full = true;
+            continue;
+        }
+        reserved += bytes;
+        stream.bytes[i] = (int)bytes;
+        stream.state[i] = STREAM_QUEUED;
+        requests[requestCount++] = i;
+    }
+
+    // Still over budget after edits grew chunks: shed whatever isn't wanted
+    StreamMakeRoom(world, 0, reserved);
+
+    pthread_mutex_lock(&stream.lock);
+    memcpy(stream.requests, requests, requestCount*sizeof(int));
+    stream.requestCount = requestCount;
+    if (requestCount > 0) pthread_cond_signal(&stream.wake);
+    pthread_mutex_unlock(&stream.lock);
+
+    stream.stats.pending = pending + requestCount;
+}
+
+WorldStreamStats GetWorldStreamStats(void)
+{
+    return stream.stats;
+}
+
+bool SaveWorldSnapshot(World *world, const char *fileName)
+{
+    if (IsWorldSaving())
+    {
+        TraceLog(LOG_WARNING, "STREAM: [%s] Previous save still running, skipped", fileName);
+        return false;
+    }
+    WaitWorldSave();
+
+    if (strlen(fileName) >= STREAM_PATH_MAX)
+    {
+        TraceLog(LOG_WARNING, "STREAM: [%s] File name too long", fileName);
+        return false;
+    }
+    if (stream.active && (strcmp(fileName, stream.fileName) == 0))
+    {
+        TraceLog(LOG_WARNING, "STREAM: [%s] Can't save over the file being streamed", fileName);
+        return false;
+    }
+
+    StreamSaveJob *job = &save.job;
+    *job = (StreamSaveJob){ .size = world->size, .chunkCount = world->chunksPerSide*world->chunksPerSide*world->chunksPerSide };
+    strcpy(job->fileName, fileName);
+    job->streamed = stream.active;
+
+    // Append while the garbage stays under half the file, otherwise write it out whole
+    bool based = (save.base[0] != '\0') && (save.header.chunkCount == job->chunkCount);
+    job->append = based && !job->streamed && (strcmp(save.base, fileName) == 0) && (2*save.header.garbage <= save.header.indexOffset);
+
+    job->items = (StreamSaveItem *)RL_MALLOC(job->chunkCount*sizeof(StreamSaveItem));
+    for (int i = 0; i < job->chunkCount; i++)
+    {
+        Chunk *chunk = &world->chunks[i];
+        bool clean = based && !chunk->dirty;
+        if (clean && job->append) continue;
+
+        StreamSaveItem *item = &job->items[job->itemCount++];
+        *item = (StreamSaveItem){ i, !clean, { 0 } };
+        if (!clean) CopyChunk(&item->chunk, chunk);
+        if (!job->streamed) chunk->dirty = false;
+    }
+
+    save.running = true;
+    save.finished = 0;
+    pthread_create(&save.thread, NULL, StreamSaveWorker, NULL);
+    return true;
+}
+
+bool IsWorldSaving(void)
+{
+    return save.running && !__atomic_load_n(&save.finished, __ATOMIC_ACQUIRE);
+}
+
+bool WaitWorldSave(void)
+{
+    if (save.running)
+    {
+        pthread_join(save.thread, NULL);
+        RL_FREE(save.job.items);
+        save.job.items = NULL;
+        save.running = false;
+    }
+    return save.ok;
+}
+
+#endif // STREAM_IMPLEMENTATION
@@ -3,6 +3,7 @@
 layout (location=0) in vec3 position;
 layout (location=2) in vec3 normal;
 layout (location=3) in vec3 color;
+in mat4 instanceTransform;
 
 out vec3 outColor;
 out vec4 modelPosition;
@@ -10,11 +11,17 @@ out vec4 worldPosition;
 
 uniform mat4 mvp;
 uniform mat4 matModel;
+uniform int instanced;
 
 void main()
 {
     outColor = color;
     modelPosition = vec4(position, 1.0);
-    worldPosition = matModel * modelPosition;
-    gl_Position = mvp * modelPosition;
+    if (instanced != 0) {
+        worldPosition = instanceTransform * modelPosition;
+        gl_Position = mvp * worldPosition;
+    } else {
+        worldPosition = matModel * modelPosition;
+        gl_Position = mvp * modelPosition;
+    }
 }
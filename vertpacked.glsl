@@ -0,0 +1,37 @@
+#version 330
+
+// PackedVertex from mesh.h, integer attributes arrive converted to float
+layout (location=0) in vec3 position;
+layout (location=1) in vec2 faceColor;
+in mat4 instanceTransform;
+
+out vec3 outColor;
+out vec3 outNormal;
+out vec4 modelPosition;
+out vec4 worldPosition;
+
+uniform mat4 mvp;
+uniform mat4 matModel;
+uniform int instanced;
+uniform float positionScale;
+uniform vec3 palette[64];
+
+const vec3 faceNormals[6] = vec3[6](
+    vec3(1.0, 0.0, 0.0), vec3(-1.0, 0.0, 0.0),
+    vec3(0.0, 1.0, 0.0), vec3(0.0, -1.0, 0.0),
+    vec3(0.0, 0.0, 1.0), vec3(0.0, 0.0, -1.0)
+);
+
+void main()
+{
+    outColor = palette[int(faceColor.y)];
+    outNormal = faceNormals[int(faceColor.x)];
+    modelPosition = vec4(position * positionScale, 1.0);
+    if (instanced != 0) {
+        worldPosition = instanceTransform * modelPosition;
+        gl_Position = mvp * worldPosition;
+    } else {
+        worldPosition = matModel * modelPosition;
+        gl_Position = mvp * modelPosition;
+    }
+}
@@ -0,0 +1,658 @@
+/**********************************************************************************************
+*
+*   world - Chunked, palette compressed voxel storage
+*
+*   The world is split into CHUNK_SIZE^3 chunks. A chunk whose voxels all hold the same
+*   value stores just that value. Otherwise it keeps a small palette of the distinct values
+*   it contains plus one bit-packed palette index per voxel, using the fewest bits (1, 2, 4,
+*   8 or 16) that can address the palette. Palette entries are reference counted so slots
+*   are reused and a chunk collapses back to a single value once it becomes uniform again.
+*
+*   Each chunk also keeps a 64 bit mask of which of its 4^3 bricks hold any non-zero voxel,
+*   so ray traversal can skip empty chunks and bricks without touching voxel data. Below that,
+*   non-uniform chunks keep a 1 bit per voxel occupancy layer, one uint64_t per 4^3 brick,
+*   updated with every voxel write. Traversal only ever asks "solid or not", and answers it
+*   from 512 bytes per chunk instead of the palette indices (uniform chunks store none, their
+*   value says it all).
+*
+*   A chunk can also be unknown: its contents are not in memory (see stream.h). It reads as
+*   empty, traversal stops at it. Every write marks the chunk dirty until whoever persists
+*   the world clears it again, and changed until SyncWorld next copies it into a snapshot.
+*
+*   SaveChunkData compresses a non-uniform chunk into a self-contained payload for world
+*   files, LoadChunkData rebuilds the chunk from it:
+*
+*       ChunkDataHeader     live palette entry count, index bits, encoding
+*       int palette[paletteCount]
+*       indices             CHUNK_ENCODING_RAW: CHUNK_VOLUME indices bit-packed, LSB first
+*                           CHUNK_ENCODING_RLE: runs of { uint16 length, uint16 index }
+*
+*   Free palette slots are dropped and the indices re-numbered, voxels go in row order
+*   (x fastest) whatever the layout, and the smaller of the two encodings is kept. Terrain
+*   like chunks, a few layers stacked along y, come down to a handful of runs. Refs,
+*   occupancy and the brick mask are not stored, loading recomputes them in the same pass
+*   that unpacks the indices. Values are in host byte order.
+*
+*   Inside a chunk the voxels are stored in rows, x fastest, unless WORLD_LAYOUT_MORTON
+*   selects Morton (Z-order) instead: the bits of x, y and z interleaved, so every aligned
+*   2^3, 4^3 and 8^3 block is contiguous and a step along y or z stays close in memory.
+*   ChunkVoxelIndex and ChunkVoxelPosition convert either way, with BMI2 pdep/pext when
+*   the compiler targets it (-mbmi2). bench compares the two layouts.
+*
+*   CONFIGURATION:
+*
+*   #define WORLD_IMPLEMENTATION
+*       Generates the implementation of the library into the included file.
+*       Only ONE file should hold the implementation.
+*
+*   #define WORLD_LAYOUT_MORTON
+*       Morton order the voxels inside each chunk. Changes ChunkVoxelIndex, so every file
+*       including world.h has to agree on it.
+*
+**********************************************************************************************/
+
+#ifndef WORLD_H
+#define WORLD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "raylib.h"
+
+#if defined(WORLD_LAYOUT_MORTON) && defined(__BMI2__)
+    #include <immintrin.h>
+#endif
+
+//----------------------------------------------------------------------------------
+// Defines and Macros
+//----------------------------------------------------------------------------------
+#define CHUNK_BITS      4
+#define CHUNK_SIZE      (1 << CHUNK_BITS)               // Voxels per chunk side
+#define CHUNK_MASK      (CHUNK_SIZE - 1)
+#define CHUNK_VOLUME    (CHUNK_SIZE*CHUNK_SIZE*CHUNK_SIZE)
+
+#define BRICK_BITS      2
+#define BRICK_SIZE      (1 << BRICK_BITS)               // Voxels per brick side
+#define BRICK_MASK      (BRICK_SIZE - 1)
+#define CHUNK_BRICKS    (CHUNK_SIZE / BRICK_SIZE)       // Bricks per chunk side
+#define CHUNK_BRICK_COUNT (CHUNK_BRICKS*CHUNK_BRICKS*CHUNK_BRICKS)
+
+#define WORLD_MAX_SIZE  2048                            // Voxels per world side InitWorld accepts
+
+#define CHUNK_ENCODING_RAW  0
+#define CHUNK_ENCODING_RLE  1
+#define CHUNK_DATA_MAX_SIZE (sizeof(ChunkDataHeader) + CHUNK_VOLUME*sizeof(int) + CHUNK_VOLUME*2)   // Largest SaveChunkData payload
+
+#define CHUNK_MORTON_X  0x249                           // Bits of x in a chunk local Morton index (CHUNK_BITS 4)
+#define CHUNK_MORTON_Y  0x492
+#define CHUNK_MORTON_Z  0x924
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct Vector3i {
+    int x;                // Vector x component
+    int y;                // Vector y component
+    int z;                // Vector z component
+} Vector3i;
+
+typedef struct Chunk {
+    int value;                  // Value of every voxel while bits == 0
+    int bits;                   // Bits per palette index, 0 for a uniform chunk
+    int paletteCount;           // Palette slots in use (including free ones)
+    bool unknown;               // Contents not in memory, reads as empty (see stream.h)
+    bool dirty;                 // Written since the last load or save cleared it
+    bool changed;               // Written or replaced since SyncWorld last copied it
+    int *palette;               // Distinct values held by the chunk
+    unsigned short *refs;       // Voxels referencing each palette slot
+    uint64_t *data;             // CHUNK_VOLUME packed palette indices
+    uint64_t bricks;            // Bit per 4^3 brick holding a non-zero voxel
+    uint64_t *occupancy;        // CHUNK_BRICK_COUNT words, bit per voxel, NULL while uniform
+} Chunk;
+
+// Start of a SaveChunkData payload
+typedef struct ChunkDataHeader {
+    unsigned short paletteCount;    // Live palette entries, the indices address these
+    unsigned char bits;             // Index bits of the chunk once loaded, and of a raw payload
+    unsigned char encoding;         // CHUNK_ENCODING_RAW or CHUNK_ENCODING_RLE
+} ChunkDataHeader;
+
+typedef struct World {
+    int size;                   // Voxels per world side
+    int chunksPerSide;          // Chunks per world side
+    Chunk *chunks;
+} World;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//----------------------------------------------------------------------------------
+// Module Functions Declaration
+//----------------------------------------------------------------------------------
+void InitWorld(World *world, int size);                    // Allocate an all-empty world of size^3 voxels, size clamped to [1, WORLD_MAX_SIZE]
+void UnloadWorld(World *world);                             // Free all chunk storage
+void ClearWorld(World *world, int v);                       // Set every voxel to v, releasing chunk storage
+void CopyWorld(World *dst, const World *src);               // Deep copy, e.g. a read-only snapshot for worker threads
+void SyncWorld(World *dst, World *src);                     // Bring a snapshot up to date, copying only the chunks changed since the last sync
+void CopyChunk(Chunk *dst, const Chunk *src);               // Deep copy of one chunk, replacing what dst held
+int WorldIndex(Vector3i p, const World *world);             // Index of the chunk holding p, -1 when outside
+int GetWorld(Vector3i p, const World *world);               // Voxel value at p, 0 when outside
+void SetWorld(Vector3i p, int v, World *world);             // Set voxel at p, ignored when outside
+int GetChunkVoxel(const Chunk *chunk, int i);               // Voxel value by chunk local index
+void SetChunkVoxel(Chunk *chunk, int i, int v);             // Set voxel by chunk local index
+size_t WorldMemoryUsage(const World *world);                // Bytes held by the world, including headers
+size_t ChunkMemoryUsage(const Chunk *chunk);                // Bytes of voxel storage, 0 for a uniform chunk
+size_t SaveChunkData(const Chunk *chunk, void *data);       // Compress a non-uniform chunk into data (CHUNK_DATA_MAX_SIZE bytes), returns the bytes used
+bool LoadChunkData(Chunk *chunk, const void *data, size_t size);    // Replace chunk with a SaveChunkData payload, false if it is malformed
+void UnloadChunkData(Chunk *chunk, int v);                  // Release the storage, leaving every voxel v
+
+#ifdef __cplusplus
+}
+#endif
+
+#if defined(WORLD_LAYOUT_MORTON)
+// Spread the CHUNK_BITS low bits of v to the positions in mask, and back
+static inline int ChunkMortonSpread(int v, unsigned int mask)
+{
+#if defined(__BMI2__)
+    return (int)_pdep_u32((unsigned int)v, mask);
+#else
+    unsigned int x = v & CHUNK_MASK;
+    x = (x | (x << 4)) & 0x0c3;
+    x = (x | (x << 2)) & 0x249;
+    return (int)(x << (__builtin_ctz(mask)));
+#endif
+}
+
+static inline int ChunkMortonCompact(int i, unsigned int mask)
+{
+#if defined(__BMI2__)
+    return (int)_pext_u32((unsigned int)i, mask);
+#else
+    unsigned int x = ((unsigned int)i >> __builtin_ctz(mask)) & 0x249;
+    x = (x | (x >> 2)) & 0x0c3;
+    x = (x | (x >> 4)) & CHUNK_MASK;
+    return (int)x;
+#endif
+}
+#endif
+
+// Chunk local index of p, x fastest or Morton order
+static inline int ChunkVoxelIndex(Vector3i p)
+{
+#if defined(WORLD_LAYOUT_MORTON)
+    return ChunkMortonSpread(p.z, CHUNK_MORTON_Z) | ChunkMortonSpread(p.y, CHUNK_MORTON_Y) | ChunkMortonSpread(p.x, CHUNK_MORTON_X);
+#else
+    return ((p.z & CHUNK_MASK) << (2*CHUNK_BITS)) |
+           ((p.y & CHUNK_MASK) << CHUNK_BITS) |
+           (p.x & CHUNK_MASK);
+#endif
+}
+
+// Chunk local position of index i, the inverse of ChunkVoxelIndex
+static inline Vector3i ChunkVoxelPosition(int i)
+{
+#if defined(WORLD_LAYOUT_MORTON)
+    return (Vector3i){ ChunkMortonCompact(i, CHUNK_MORTON_X), ChunkMortonCompact(i, CHUNK_MORTON_Y), ChunkMortonCompact(i, CHUNK_MORTON_Z) };
+#else
+    return (Vector3i){ i & CHUNK_MASK, (i >> CHUNK_BITS) & CHUNK_MASK, i >> (2*CHUNK_BITS) };
+#endif
+}
+
+// Bit of the chunk brick mask covering p
+static inline int ChunkBrickIndex(Vector3i p)
+{
+    return (((p.z & CHUNK_MASK) >> BRICK_BITS) * CHUNK_BRICKS + ((p.y & CHUNK_MASK) >> BRICK_BITS)) * CHUNK_BRICKS +
+           ((p.x & CHUNK_MASK) >> BRICK_BITS);
+}
+
+// Bit of p in the occupancy word of its brick, x fastest
+static inline int BrickVoxelBit(Vector3i p)
+{
+    return ((p.z & BRICK_MASK) << (2*BRICK_BITS)) | ((p.y & BRICK_MASK) << BRICK_BITS) | (p.x & BRICK_MASK);
+}
+
+// Occupancy word of a brick by its ChunkBrickIndex, uniform chunks derive it from their value
+static inline uint64_t GetBrickOccupancy(const Chunk *chunk, int brick)
+{
+    if (chunk->occupancy) return chunk->occupancy[brick];
+    return chunk->value ? ~0ull : 0;
+}
+
+#endif // WORLD_H
+
+/***********************************************************************************
+*
+*   WORLD IMPLEMENTATION
+*
+************************************************************************************/
+
+#if defined(WORLD_IMPLEMENTATION) && !defined(WORLD_IMPLEMENTED)
+#define WORLD_IMPLEMENTED
+
+#include <string.h>
+
+// A chunk never holds more than CHUNK_VOLUME distinct values
+static int ChunkPaletteCapacity(int bits)
+{
+    return (bits >= 3*CHUNK_BITS) ? CHUNK_VOLUME : (1 << bits);
+}
+
+static int ChunkGetIndex(const Chunk *chunk, int i)
+{
+    int perWord = 64 / chunk->bits;
+    int shift = (i % perWord) * chunk->bits;
+    return (int)((chunk->data[i / perWord] >> shift) & ((1u << chunk->bits) - 1));
+}
+
+static void ChunkSetIndex(Chunk *chunk, int i, int index)
+{
+    int perWord = 64 / chunk->bits;
+    int shift = (i % perWord) * chunk->bits;
+    uint64_t mask = (uint64_t)((1u << chunk->bits) - 1) << shift;
+    uint64_t *word = &chunk->data[i / perWord];
+    *word = (*word & ~mask) | ((uint64_t)index << shift);
+}
+
+static void ChunkFree(Chunk *chunk, int v)
+{
+    RL_FREE(chunk->palette);
+    RL_FREE(chunk->refs);
+    RL_FREE(chunk->data);
+    RL_FREE(chunk->occupancy);
+    *chunk = (Chunk){ .value = v, .changed = true, .bricks = v ? ~0ull : 0 };
+}
+
+// Re-pack the indices with a new bit width, growing the palette arrays to match
+static void ChunkResize(Chunk *chunk, int bits)
+{
+    uint64_t *data = (uint64_t *)RL_CALLOC(CHUNK_VOLUME * bits / 64, sizeof(uint64_t));
+    Chunk packed = *chunk;
+    packed.bits = bits;
+    packed.data = data;
+
+    for (int i = 0; i < CHUNK_VOLUME; i++)
+    {
+        ChunkSetIndex(&packed, i, ChunkGetIndex(chunk, i));
+    }
+
+    RL_FREE(chunk->data);
+    chunk->data = data;
+    chunk->bits = bits;
+    chunk->palette = (int *)RL_REALLOC(chunk->palette, ChunkPaletteCapacity(bits) * sizeof(int));
+    chunk->refs = (unsigned short *)RL_REALLOC(chunk->refs, ChunkPaletteCapacity(bits) * sizeof(unsigned short));
+}
+
+// Palette slot for v, adding it (and widening the indices) when not present
+static int ChunkPaletteSlot(Chunk *chunk, int v)
+{
+    int freeSlot = -1;
+    for (int i = 0; i < chunk->paletteCount; i++)
+    {
+        if (chunk->refs[i] == 0)
+        {
+            if (freeSlot < 0) freeSlot = i;
+        }
+        else if (chunk->palette[i] == v)
+        {
+            return i;
+        }
+    }
+
+    if (freeSlot < 0)
+    {
+        if (chunk->paletteCount == ChunkPaletteCapacity(chunk->bits)) ChunkResize(chunk, chunk->bits * 2);
+        freeSlot = chunk->paletteCount++;
+        chunk->refs[freeSlot] = 0;
+    }
+
+    chunk->palette[freeSlot] = v;
+    return freeSlot;
+}
+
+void InitWorld(World *world, int size)
+{
+    if (size < 1 || size > WORLD_MAX_SIZE)
+    {
+        TraceLog(LOG_WARNING, "WORLD: Size %d out of range, using %d", size, (size < 1) ? 1 : WORLD_MAX_SIZE);
+        size = (size < 1) ? 1 : WORLD_MAX_SIZE;
+    }
+
+    world->size = size;
+    world->chunksPerSide = (size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    int count = world->chunksPerSide * world->chunksPerSide * world->chunksPerSide;
+    world->chunks = (Chunk *)RL_CALLOC(count, sizeof(Chunk));
+    for (int i = 0; i < count; i++)
+    {
+        world->chunks[i].changed = true;
+    }
+}
+
+void UnloadWorld(World *world)
+{
+    ClearWorld(world, 0);
+    RL_FREE(world->chunks);
+    *world = (World){0};
+}
+
+void ClearWorld(World *world, int v)
+{
+    int count = world->chunksPerSide * world->chunksPerSide * world->chunksPerSide;
+    for (int i = 0; i < count; i++)
+    {
+        // Chunks already holding only v stay as they are, they haven't changed
+        Chunk *chunk = &world->chunks[i];
+        if (chunk->bits == 0 && chunk->value == v && !chunk->unknown) continue;
+        ChunkFree(chunk, v);
+        chunk->dirty = true;
+    }
+}
+
+void CopyWorld(World *dst, const World *src)
+{
+    if (dst->chunks && dst->size == src->size)
+    {
+        ClearWorld(dst, 0);
+    }
+    else
+    {
+        if (dst->chunks) UnloadWorld(dst);
+        InitWorld(dst, src->size);
+    }
+
+    int count = src->chunksPerSide * src->chunksPerSide * src->chunksPerSide;
+    for (int i = 0; i < count; i++)
+    {
+        CopyChunk(&dst->chunks[i], &src->chunks[i]);
+    }
+}
+
+// Only one snapshot can follow a world this way: the sync clears the flags it goes by
+void SyncWorld(World *dst, World *src)
+{
+    bool all = !dst->chunks || dst->size != src->size;
+    if (all)
+    {
+        if (dst->chunks) UnloadWorld(dst);
+        InitWorld(dst, src->size);
+    }
+
+    int count = src->chunksPerSide * src->chunksPerSide * src->chunksPerSide;
+    for (int i = 0; i < count; i++)
+    {
+        if (!all && !src->chunks[i].changed) continue;
+        CopyChunk(&dst->chunks[i], &src->chunks[i]);
+        src->chunks[i].changed = false;
+    }
+}
+
+void CopyChunk(Chunk *dst, const Chunk *src)
+{
+    ChunkFree(dst, 0);
+    *dst = *src;
+    if (src->bits == 0) return;
+
+    int capacity = ChunkPaletteCapacity(src->bits);
+    dst->palette = (int *)RL_MALLOC(capacity * sizeof(int));
+    dst->refs = (unsigned short *)RL_MALLOC(capacity * sizeof(unsigned short));
+    dst->data = (uint64_t *)RL_MALLOC(CHUNK_VOLUME * src->bits / 8);
+    memcpy(dst->palette, src->palette, src->paletteCount * sizeof(int));
+    memcpy(dst->refs, src->refs, src->paletteCount * sizeof(unsigned short));
+    memcpy(dst->data, src->data, CHUNK_VOLUME * src->bits / 8);
+    dst->occupancy = (uint64_t *)RL_MALLOC(CHUNK_BRICK_COUNT * sizeof(uint64_t));
+    memcpy(dst->occupancy, src->occupancy, CHUNK_BRICK_COUNT * sizeof(uint64_t));
+}
+
+int WorldIndex(Vector3i p, const World *world)
+{
+    if (p.x < 0 || p.y < 0 || p.z < 0 ||
+        p.x >= world->size || p.y >= world->size || p.z >= world->size) {
+        return -1;
+    }
+
+    int n = world->chunksPerSide;
+    return ((p.z >> CHUNK_BITS) * n + (p.y >> CHUNK_BITS)) * n + (p.x >> CHUNK_BITS);
+}
+
+int GetChunkVoxel(const Chunk *chunk, int i)
+{
+    if (chunk->bits == 0) return chunk->value;
+    return chunk->palette[ChunkGetIndex(chunk, i)];
+}
+
+void SetChunkVoxel(Chunk *chunk, int i, int v)
+{
+    if (chunk->bits == 0)
+    {
+        if (chunk->value == v) return;
+
+        // Split a uniform chunk: slot 0 keeps the old value for every voxel
+        chunk->bits = 1;
+        chunk->paletteCount = 1;
+        chunk->palette = (int *)RL_MALLOC(2 * sizeof(int));
+        chunk->refs = (unsigned short *)RL_MALLOC(2 * sizeof(unsigned short));
+        chunk->data = (uint64_t *)RL_CALLOC(CHUNK_VOLUME / 64, sizeof(uint64_t));
+        chunk->occupancy = (uint64_t *)RL_MALLOC(CHUNK_BRICK_COUNT * sizeof(uint64_t));
+        chunk->palette[0] = chunk->value;
+        chunk->refs[0] = CHUNK_VOLUME;
+        for (int b = 0; b < CHUNK_BRICK_COUNT; b++)
+        {
+            chunk->occupancy[b] = chunk->value ? ~0ull : 0;
+        }
+    }
+
+    int old = ChunkGetIndex(chunk, i);
+    if (chunk->palette[old] == v) return;
+
+    // Release first so the old slot can be reused if this was its last voxel
+    chunk->refs[old]--;
+    int slot = ChunkPaletteSlot(chunk, v);
+    ChunkSetIndex(chunk, i, slot);
+    chunk->refs[slot]++;
+
+    if (chunk->refs[slot] == CHUNK_VOLUME)
+    {
+        ChunkFree(chunk, v);
+        chunk->dirty = true;
+        return;
+    }
+    chunk->dirty = true;
+    chunk->changed = true;
+
+    Vector3i p = ChunkVoxelPosition(i);
+    int brick = ChunkBrickIndex(p);
+    uint64_t bit = 1ull << BrickVoxelBit(p);
+    if (v) chunk->occupancy[brick] |= bit;
+    else chunk->occupancy[brick] &= ~bit;
+
+    if (chunk->occupancy[brick]) chunk->bricks |= 1ull << brick;
+    else chunk->bricks &= ~(1ull << brick);
+}
+
+int GetWorld(Vector3i p, const World *world)
+{
+    int c = WorldIndex(p, world);
+    if (c < 0) return 0;
+    return GetChunkVoxel(&world->chunks[c], ChunkVoxelIndex(p));
+}
+
+void SetWorld(Vector3i p, int v, World *world)
+{
+    int c = WorldIndex(p, world);
+    if (c >= 0) {
+        SetChunkVoxel(&world->chunks[c], ChunkVoxelIndex(p), v);
+    }
+}
+
+size_t WorldMemoryUsage(const World *world)
+{
+    int count = world->chunksPerSide * world->chunksPerSide * world->chunksPerSide;
+    size_t bytes = sizeof(World) + count * sizeof(Chunk);
+    for (int i = 0; i < count; i++)
+    {
+        bytes += ChunkMemoryUsage(&world->chunks[i]);
+    }
+    return bytes;
+}
+
+size_t ChunkMemoryUsage(const Chunk *chunk)
+{
+    if (chunk->bits == 0) return 0;
+    return CHUNK_VOLUME * chunk->bits / 8 +
+           ChunkPaletteCapacity(chunk->bits) * (sizeof(int) + sizeof(unsigned short)) +
+           CHUNK_BRICK_COUNT * sizeof(uint64_t);
+}
+
+// Fewest index bits ChunkResize allows for count palette entries
+static int ChunkDataBits(int count)
+{
+    int bits = 1;
+    while ((1 << bits) < count) bits *= 2;
+    return bits;
+}
+
+// Chunk local index of the voxel at row order position l
+static inline int ChunkRowIndex(int l)
+{
+    return ChunkVoxelIndex((Vector3i){ l & CHUNK_MASK, (l >> CHUNK_BITS) & CHUNK_MASK, l >> (2*CHUNK_BITS) });
+}
+
+size_t SaveChunkData(const Chunk *chunk, void *data)
+{
+    if (chunk->bits == 0) return 0;
+
+    // Compact the palette, free slots go
+    unsigned char *out = (unsigned char *)data;
+    unsigned short remap[CHUNK_VOLUME];
+    int count = 0;
+    for (int s = 0; s < chunk->paletteCount; s++)
+    {
+        if (chunk->refs[s] == 0) continue;
+        remap[s] = (unsigned short)count;
+        memcpy(out + sizeof(ChunkDataHeader) + count*sizeof(int), &chunk->palette[s], sizeof(int));
+        count++;
+    }
+
+    ChunkDataHeader header = { (unsigned short)count, (unsigned char)ChunkDataBits(count), CHUNK_ENCODING_RLE };
+    unsigned char *indices = out + sizeof(ChunkDataHeader) + count*sizeof(int);
+    size_t rawBytes = CHUNK_VOLUME*header.bits/8;
+
+    // Runs first, given up as soon as they get longer than the packed indices
+    size_t bytes = 0;
+    unsigned short run[2] = { 0, (unsigned short)remap[ChunkGetIndex(chunk, ChunkRowIndex(0))] };
+    for (int l = 0; l <= CHUNK_VOLUME && bytes <= rawBytes; l++)
+    {
+        int index = (l < CHUNK_VOLUME) ? remap[ChunkGetIndex(chunk, ChunkRowIndex(l))] : -1;
+        if (index == run[1])
+        {
+            run[0]++;
+            continue;
+        }
+        if (bytes + sizeof(run) <= rawBytes) memcpy(indices + bytes, run, sizeof(run));
+        bytes += sizeof(run);
+        run[0] = 1;
+        run[1] = (unsigned short)index;
+    }
+
+    if (bytes > rawBytes)
+    {
+        header.encoding = CHUNK_ENCODING_RAW;
+        bytes = rawBytes;
+        memset(indices, 0, rawBytes);
+        for (int l = 0; l < CHUNK_VOLUME; l++)
+        {
+            unsigned int index = remap[ChunkGetIndex(chunk, ChunkRowIndex(l))];
+            int bit = l*header.bits;
+            indices[bit/8] |= (unsigned char)(index << (bit % 8));
+            if (header.bits == 16) indices[bit/8 + 1] = (unsigned char)(index >> 8);
+        }
+    }
+
+    memcpy(out, &header, sizeof(header));
+    return sizeof(ChunkDataHeader) + count*sizeof(int) + bytes;
+}
+
+// Palette index of row order voxel l, counting it in refs, occupancy and bricks
+static void ChunkLoadVoxel(Chunk *chunk, int l, int index)
+{
+    int i = ChunkRowIndex(l);
+    ChunkSetIndex(chunk, i, index);
+    chunk->refs[index]++;
+    if (chunk->palette[index] == 0) return;
+
+    Vector3i p = ChunkVoxelPosition(i);
+    int brick = ChunkBrickIndex(p);
+    chunk->occupancy[brick] |= 1ull << BrickVoxelBit(p);
+    chunk->bricks |= 1ull << brick;
+}
+
+bool LoadChunkData(Chunk *chunk, const void *data, size_t size)
+{
+    const unsigned char *in = (const unsigned char *)data;
+    ChunkDataHeader header = { 0 };
+    if (size < sizeof(header)) return false;
+    memcpy(&header, in, sizeof(header));
+
+    int count = header.paletteCount;
+    if (count < 1 || count > CHUNK_VOLUME || header.bits != ChunkDataBits(count) ||
+        size < sizeof(header) + count*sizeof(int)) return false;
+
+    const unsigned char *indices = in + sizeof(header) + count*sizeof(int);
+    size_t bytes = size - sizeof(header) - count*sizeof(int);
+    if ((header.encoding == CHUNK_ENCODING_RAW) ? (bytes != (size_t)CHUNK_VOLUME*header.bits/8) :
+        (header.encoding != CHUNK_ENCODING_RLE || bytes == 0 || bytes % 4 != 0)) return false;
+
+    int capacity = ChunkPaletteCapacity(header.bits);
+    Chunk loaded = { .bits = header.bits, .paletteCount = count };
+    loaded.palette = (int *)RL_MALLOC(capacity * sizeof(int));
+    loaded.refs = (unsigned short *)RL_CALLOC(capacity, sizeof(unsigned short));
+    loaded.data = (uint64_t *)RL_CALLOC(CHUNK_VOLUME * header.bits / 64, sizeof(uint64_t));
+    loaded.occupancy = (uint64_t *)RL_CALLOC(CHUNK_BRICK_COUNT, sizeof(uint64_t));
+    memcpy(loaded.palette, in + sizeof(header), count*sizeof(int));
+
+    bool ok = true;
+    if (header.encoding == CHUNK_ENCODING_RAW)
+    {
+        for (int l = 0; l < CHUNK_VOLUME && ok; l++)
+        {
+            int bit = l*header.bits;
+            int index = (indices[bit/8] >> (bit % 8)) & ((1 << header.bits) - 1);
+            if (header.bits == 16) index = indices[bit/8] | (indices[bit/8 + 1] << 8);
+            ok = (index < count);
+            if (ok) ChunkLoadVoxel(&loaded, l, index);
+        }
+    }
+    else
+    {
+        int l = 0;
+        for (size_t r = 0; r < bytes && ok; r += 4)
+        {
+            unsigned short run[2];
+            memcpy(run, indices + r, sizeof(run));
+            ok = (run[1] < count) && (l + run[0] <= CHUNK_VOLUME);
+            for (int k = 0; k < run[0] && ok; k++) ChunkLoadVoxel(&loaded, l++, run[1]);
+        }
+        ok = ok && (l == CHUNK_VOLUME);
+    }
+
+    if (!ok)
+    {
+        ChunkFree(&loaded, 0);
+        return false;
+    }
+
+    // A payload may hold a single value, keep chunks uniform when they are
+    ChunkFree(chunk, 0);
+    *chunk = loaded;
+    chunk->changed = true;
+    if (loaded.refs[0] == CHUNK_VOLUME) ChunkFree(chunk, loaded.palette[0]);
+    return true;
+}
+
+void UnloadChunkData(Chunk *chunk, int v)
+{
+    ChunkFree(chunk, v);
+}
+
+#endif // WORLD_IMPLEMENTATION